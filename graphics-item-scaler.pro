@@ -11,17 +11,12 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 TARGET = graphics-item-scaler
 TEMPLATE = app
 
+include(scaler/scaler.pri)
 
 SOURCES += main.cpp\
-        mainwindow.cpp \
-        scaler/graphicsitemscaler.cpp \
-        scaler/handleitem.cpp \
-        scaler/handlerstrategies.cpp
-
-HEADERS  += mainwindow.h \
-    scaler/graphicsitemscaler.h \
-    scaler/handleitem.h \
-    scaler/handlerstrategies.h
+        mainwindow.cpp
+
+HEADERS  += mainwindow.h
 
 FORMS    += mainwindow.ui
 
@@ -1,6 +1,9 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include <QAction>
 #include <QGraphicsRectItem>
+#include <QSignalBlocker>
+#include <QUndoStack>
 #include <QDebug>
 
 MainWindow::MainWindow(QWidget *parent) :
@@ -21,6 +24,17 @@ MainWindow::MainWindow(QWidget *parent) :
     scaler->setBoundingRectAreaVisible(true);
     scene->addItem(scaler);
 
+    QUndoStack *undoStack = new QUndoStack(this);
+    scaler->setUndoStack(undoStack);
+
+    QAction *undoAction = undoStack->createUndoAction(this);
+    undoAction->setShortcuts(QKeySequence::Undo);
+    addAction(undoAction);
+
+    QAction *redoAction = undoStack->createRedoAction(this);
+    redoAction->setShortcuts(QKeySequence::Redo);
+    addAction(redoAction);
+
     ui->graphicsView->setScene(scene);
     ui->graphicsView->setAlignment(Qt::AlignTop | Qt::AlignLeft);
 
@@ -36,8 +50,12 @@ MainWindow::MainWindow(QWidget *parent) :
         ui->graphicsView->scale((1.0 / 1.2), (1.0 / 1.2));
     });
     connect(ui->spinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [&]() {
-        mTestItem->setRotation(ui->spinBox->value());
-        mScaler->recalculate(); // You have to call it every time your item's rotation is changed
+        mScaler->setRotationAroundCenter(ui->spinBox->value());
+    });
+    // Follows rotation drags as well as undo and redo
+    connect(scaler, &GraphicsItemScaler::rotationChanged, this, [&]() {
+        QSignalBlocker blocker(ui->spinBox);
+        ui->spinBox->setValue(qRound(mScaler->rotation()));
     });
 }
 
@@ -1,24 +1,46 @@
 #include "graphicsitemscaler.h"
 #include "handleitem.h"
+#include "rotationhandleitem.h"
+#include "pixmapscalingcache.h"
+#include "scalercommands.h"
+#include "scalermirror.h"
 #include <QDebug>
+#include <QGraphicsPixmapItem>
 #include <QPainter>
+#include <QTimer>
 #include <QTransform>
+#include <QUndoStack>
+#include <QtMath>
 
 static QSizeF handleSize = QSizeF(6, 6);
 static QMarginsF handleBounds = QMarginsF(handleSize.width(), handleSize.height(), handleSize.width(), handleSize.height());
+static qreal rotationHandleDistance = 20;
+// Room reserved on every side of the frame while it is dragged, relative to its size
+static qreal dragReserve = 0.25;
 
 GraphicsItemScaler::GraphicsItemScaler(QGraphicsItem* target, QGraphicsItem *parent)
     : QGraphicsObject(parent)
+    , mRotationHandleItem(nullptr)
     , mTarget(target)
+    , mTargetParent(nullptr)
+    , mTargetMovable(false)
+    , mBoundingRectAreaVisible(false)
+    , mHandlersIgnoreTransformations(false)
+    , mInteractiveScaling(false)
+    , mPixmapScalingCache(nullptr)
+    , mTargetOpacity(1)
+    , mHandleEventRecorder(nullptr)
+    , mScalingChangedFrequency(30)
+    , mScalingChangedPending(false)
+    , mScalingChangedTimer(new QTimer(this))
 {
-    Q_ASSERT(mTarget);
+    mScalingChangedTimer->setSingleShot(true);
+    connect(mScalingChangedTimer, &QTimer::timeout, this, &GraphicsItemScaler::emitScalingChanged);
 
     setFlag(ItemIsMovable);
     setFlag(ItemHasNoContents);
-
-    mTarget->setParentItem(this);
-    mTarget->setPos(handleBounds.left(), handleBounds.top());
-    mTarget->setFlag(ItemIsMovable, false);
+    // Rotation changes reach itemChange() only with this flag
+    setFlag(ItemSendsGeometryChanges);
 
     QPen p(Qt::gray, 1, Qt::DashLine);
     p.setCosmetic(true);
@@ -37,12 +59,26 @@ GraphicsItemScaler::GraphicsItemScaler(QGraphicsItem* target, QGraphicsItem *par
     mHandleItems.append(new HandleItem(HandleItem::Bottom | HandleItem::Right, handleSize, this));
     mHandleItems.append(new HandleItem(HandleItem::Bottom | HandleItem::Left, handleSize, this));
 
+    mRotationHandleItem = new RotationHandleItem(handleSize, rotationHandleDistance, this);
+
+    if (mTarget)
+        attachTarget();
+    else
+        setVisible(false);
+
     recalculate();
+
+    if (mTarget)
+        adoptTargetRotation();
 }
 
 GraphicsItemScaler::~GraphicsItemScaler()
 {
-
+    // The target is deleted as a child below, e.g. when the scene is cleared, where
+    // itemChange() does not reach this class anymore. Removing a selected item emits
+    // selectionChanged() then, nobody may reach it through target()
+    unregisterTarget();
+    mTarget = nullptr;
 }
 
 QBrush GraphicsItemScaler::handleItemBrush() const
@@ -71,6 +107,18 @@ bool GraphicsItemScaler::boundingRectAreaVisible() const
 }
 
 QRectF GraphicsItemScaler::boundingRect() const
+{
+    return mBoundingRect;
+}
+
+QPainterPath GraphicsItemScaler::shape() const
+{
+    QPainterPath path;
+    path.addRect(mBounds);
+    return path;
+}
+
+QRectF GraphicsItemScaler::handlesRect() const
 {
     return mBounds;
 }
@@ -80,6 +128,15 @@ void GraphicsItemScaler::paint(QPainter *painter, const QStyleOptionGraphicsItem
     Q_UNUSED(option)
     Q_UNUSED(widget)
 
+    if (mPixmapScalingCache && mTarget)
+    {
+        painter->save();
+        painter->setTransform(mTarget->itemTransform(this), true);
+        painter->setOpacity(painter->opacity() * mTargetOpacity);
+        mPixmapScalingCache->paint(painter, mInteractiveScaling);
+        painter->restore();
+    }
+
     if (boundingRectAreaVisible())
     {
         painter->setPen(boundingRectAreaPen());
@@ -88,6 +145,21 @@ void GraphicsItemScaler::paint(QPainter *painter, const QStyleOptionGraphicsItem
     }
 }
 
+QVariant GraphicsItemScaler::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    // Undo, redo and retargeting rotate the scaler directly, handles ignoring
+    // transformations have to follow it
+    if (change == ItemRotationHasChanged)
+        updateHandleItemPositions();
+
+    // The target is destroyed or reparented by someone else. Deleting a selected target
+    // emits selectionChanged() only after that, so it must not be released anymore
+    if (change == ItemChildRemovedChange && mTarget && value.value<QGraphicsItem *>() == mTarget)
+        dropTarget();
+
+    return QGraphicsObject::itemChange(change, value);
+}
+
 void GraphicsItemScaler::setHandleItemPen(const QPen &pen)
 {
     if (mHandleItemPen != pen)
@@ -96,6 +168,7 @@ void GraphicsItemScaler::setHandleItemPen(const QPen &pen)
 
         for (HandleItem *i : mHandleItems)
             i->setPen(pen);
+        mRotationHandleItem->setPen(pen);
     }
 }
 
@@ -107,6 +180,7 @@ void GraphicsItemScaler::setHandleItemBrush(const QBrush &brush)
 
         for (HandleItem *i : mHandleItems)
             i->setBrush(brush);
+        mRotationHandleItem->setBrush(brush);
     }
 }
 
@@ -133,19 +207,14 @@ void GraphicsItemScaler::setBoundingRectAreaVisible(bool visible)
     if (mBoundingRectAreaVisible != visible)
     {
         mBoundingRectAreaVisible = visible;
-        setFlag(ItemHasNoContents, !mBoundingRectAreaVisible);
+        updateContentsFlag();
         update();
     }
 }
 
 void GraphicsItemScaler::recalculate()
 {
-    auto rect = targetBoundingRect();
-    auto diff = rect.topLeft() - QPointF(handleBounds.left(), handleBounds.top());
-
-    updateBoundingRectSize((QRectF(QPointF(), rect.size()) + handleBounds).size());
-
-    mTarget->setPos(mTarget->pos() - diff);
+    fitFrame(Qt::TopLeftCorner);
 }
 
 QGraphicsItem *GraphicsItemScaler::target() const
@@ -153,11 +222,99 @@ QGraphicsItem *GraphicsItemScaler::target() const
     return mTarget;
 }
 
+void GraphicsItemScaler::setTarget(QGraphicsItem *target)
+{
+    if (mTarget == target)
+        return;
+
+    // A drag in progress belongs to the old target: it is finished, so it can be undone,
+    // and the handles do not apply the rest of it to the new target
+    if (mInteractiveScaling)
+    {
+        for (HandleItem *i : mHandleItems)
+            i->abortDrag();
+        mRotationHandleItem->abortDrag();
+        endInteractiveScaling();
+    }
+
+    auto pixmapScaling = progressivePixmapScaling();
+    setProgressivePixmapScaling(false);
+
+    releaseTarget();
+    mTarget = target;
+
+    if (!mTarget)
+    {
+        setVisible(false);
+        return;
+    }
+
+    auto scenePos = mTarget->scenePos();
+
+    setRotation(0);
+    setTransformOriginPoint(QPointF());
+    attachTarget();
+    recalculate();
+
+    // Keep the target where it was in the scene
+    auto parent = parentItem();
+    auto offset = parent ? parent->mapFromScene(scenePos) - parent->mapFromScene(mTarget->scenePos())
+                         : scenePos - mTarget->scenePos();
+    setPos(pos() + offset);
+
+    adoptTargetRotation();
+
+    setProgressivePixmapScaling(pixmapScaling);
+    setVisible(true);
+}
+
+GraphicsItemScaler *GraphicsItemScaler::scalerOf(const QGraphicsItem *item)
+{
+    auto parent = item ? item->parentItem() : nullptr;
+    auto scaler = qobject_cast<GraphicsItemScaler *>(parent ? parent->toGraphicsObject() : nullptr);
+
+    return scaler && scaler->target() == item ? scaler : nullptr;
+}
+
 QRectF GraphicsItemScaler::targetBoundingRect() const
 {
+    if (!mTarget)
+        return QRectF();
+
+    auto transform = mTarget->itemTransform(this);
+
+    if (transform.type() <= QTransform::TxScale)
+        return transform.mapRect(mTargetShapeRect);
+
+    // Target is rotated or sheared inside the scaler
     return mapFromItem(mTarget, mTarget->shape()).boundingRect();
 }
 
+bool GraphicsItemScaler::rotationHandleVisible() const
+{
+    return mRotationHandleItem->isVisible();
+}
+
+void GraphicsItemScaler::setRotationHandleVisible(bool visible)
+{
+    mRotationHandleItem->setVisible(visible);
+}
+
+void GraphicsItemScaler::setRotationAroundCenter(qreal angle)
+{
+    auto center = mBounds.center();
+
+    if (transformOriginPoint() != center)
+    {
+        // Moving the origin of a rotated item moves the item, compensate it
+        auto before = mapToParent(QPointF());
+        setTransformOriginPoint(center);
+        setPos(pos() + before - mapToParent(QPointF()));
+    }
+
+    setRotation(angle);
+}
+
 bool GraphicsItemScaler::handlersIgnoreTransformations() const
 {
     return mHandlersIgnoreTransformations;
@@ -171,6 +328,280 @@ void GraphicsItemScaler::setHandlersIgnoreTransformations(bool ignore)
 
         for (auto handleItem : mHandleItems)
             handleItem->setFlag(ItemIgnoresTransformations, ignore);
+        mRotationHandleItem->setFlag(ItemIgnoresTransformations, ignore);
+
+        updateHandleItemPositions();
+    }
+}
+
+QUndoStack *GraphicsItemScaler::undoStack() const
+{
+    return mUndoStack;
+}
+
+void GraphicsItemScaler::setUndoStack(QUndoStack *stack)
+{
+    mUndoStack = stack;
+}
+
+bool GraphicsItemScaler::progressivePixmapScaling() const
+{
+    return mPixmapScalingCache != nullptr;
+}
+
+void GraphicsItemScaler::setProgressivePixmapScaling(bool enabled)
+{
+    if (progressivePixmapScaling() == enabled)
+        return;
+
+    if (enabled)
+    {
+        auto pixmapItem = qgraphicsitem_cast<QGraphicsPixmapItem *>(mTarget);
+        if (!pixmapItem)
+            return;
+
+        mPixmapScalingCache = new PixmapScalingCache(pixmapItem, this);
+        connect(mPixmapScalingCache, &PixmapScalingCache::changed, this, [this]() { update(); });
+
+        mTargetOpacity = mTarget->opacity();
+        mTarget->setOpacity(0);
+    }
+    else
+    {
+        delete mPixmapScalingCache;
+        mPixmapScalingCache = nullptr;
+
+        mTarget->setOpacity(mTargetOpacity);
+    }
+
+    updateContentsFlag();
+    update();
+}
+
+HandleEventRecorder *GraphicsItemScaler::handleEventRecorder() const
+{
+    return mHandleEventRecorder;
+}
+
+void GraphicsItemScaler::setHandleEventRecorder(HandleEventRecorder *recorder)
+{
+    mHandleEventRecorder = recorder;
+}
+
+QGraphicsItem *GraphicsItemScaler::handleItem(int attachmentFlags) const
+{
+    if (attachmentFlags == RotationHandleItem::Attachment)
+        return mRotationHandleItem;
+
+    for (HandleItem *i : mHandleItems)
+    {
+        if (i->attachmentFlags() == attachmentFlags)
+            return i;
+    }
+    return nullptr;
+}
+
+int GraphicsItemScaler::scalingChangedFrequency() const
+{
+    return mScalingChangedFrequency;
+}
+
+void GraphicsItemScaler::setScalingChangedFrequency(int frequency)
+{
+    mScalingChangedFrequency = qMax(0, frequency);
+}
+
+int GraphicsItemScaler::touchBatchInterval()
+{
+    return HandleItem::TouchBatchInterval;
+}
+
+void GraphicsItemScaler::setTouchBatchInterval(int msec)
+{
+    HandleItem::TouchBatchInterval = qMax(0, msec);
+
+    if (HandleItem::TouchBatchTimer)
+        HandleItem::TouchBatchTimer->setInterval(HandleItem::TouchBatchInterval);
+}
+
+void GraphicsItemScaler::beginInteractiveScaling()
+{
+    mInteractiveScaling = true;
+    mScalingStartState = ScalerState::capture(mTarget);
+
+    mScalingChangedClock.invalidate();
+    emit scalingStarted();
+}
+
+void GraphicsItemScaler::endInteractiveScaling()
+{
+    if (!mInteractiveScaling)
+        return;
+
+    mInteractiveScaling = false;
+    normalizeFrame();
+    shrinkBoundingRect();
+
+    // Switch from the mip level to the high quality rescale
+    if (mPixmapScalingCache)
+        update();
+
+    if (mUndoStack)
+    {
+        auto after = ScalerState::capture(mTarget);
+
+        if (mScalingStartState != after)
+            mUndoStack->push(new ScaleCommand(mTarget, mScalingStartState, after));
+    }
+
+    // Flush a change held back by the rate limit
+    emitScalingChanged();
+    emit scalingFinished();
+}
+
+void GraphicsItemScaler::cancelInteractiveScaling()
+{
+    if (!mInteractiveScaling)
+        return;
+
+    mInteractiveScaling = false;
+    normalizeFrame();
+    shrinkBoundingRect();
+
+    if (mTarget)
+        mScalingStartState.applyTo(mTarget);
+
+    if (mPixmapScalingCache)
+        update();
+
+    mScalingChangedPending = true;
+    emitScalingChanged();
+    emit scalingFinished();
+}
+
+void GraphicsItemScaler::notifyScalingChanged()
+{
+    mScalingChangedPending = true;
+
+    if (mScalingChangedTimer->isActive())
+        return;
+
+    qint64 interval = mScalingChangedFrequency > 0 ? 1000 / mScalingChangedFrequency : 0;
+    qint64 elapsed = mScalingChangedClock.isValid() ? mScalingChangedClock.elapsed() : interval;
+
+    if (elapsed >= interval)
+        emitScalingChanged();
+    else
+        mScalingChangedTimer->start(int(interval - elapsed));
+}
+
+void GraphicsItemScaler::emitScalingChanged()
+{
+    mScalingChangedTimer->stop();
+
+    if (!mScalingChangedPending)
+        return;
+
+    mScalingChangedPending = false;
+    mScalingChangedClock.start();
+
+    emit scalingChanged(mapRectToScene(targetBoundingRect()));
+}
+
+void GraphicsItemScaler::attachTarget()
+{
+    mTargetParent = mTarget->parentItem();
+    mTargetMovable = mTarget->flags() & ItemIsMovable;
+
+    mTarget->setParentItem(this);
+    mTarget->setPos(handleBounds.left(), handleBounds.top());
+    mTarget->setFlag(ItemIsMovable, false);
+}
+
+void GraphicsItemScaler::releaseTarget()
+{
+    if (!mTarget)
+        return;
+
+    auto target = mTarget;
+    auto sceneTransform = target->sceneTransform();
+    auto scenePos = target->scenePos();
+
+    // Cleared first, so itemChange() does not take the reparenting for a removal
+    mTarget = nullptr;
+
+    target->setParentItem(mTargetParent);
+    target->setPos(mTargetParent ? mTargetParent->mapFromScene(scenePos) : scenePos);
+    target->setFlag(ItemIsMovable, mTargetMovable);
+
+    // Keep the rotation of the scaler in the target transform
+    if (!qFuzzyIsNull(rotation()))
+        target->setTransform(sceneTransform * target->sceneTransform().inverted() * target->transform());
+
+    mTargetParent = nullptr;
+}
+
+void GraphicsItemScaler::adoptTargetRotation()
+{
+    // Transform of the target to the scaler without its position
+    auto local = mTarget->itemTransform(this) * QTransform::fromTranslate(-mTarget->x(), -mTarget->y());
+    if ((qFuzzyIsNull(local.m12()) && local.m11() > 0) || !local.isInvertible())
+        return;
+
+    // Handles scale along the axes of the scaler, so a rotated target would be sheared and
+    // its frame would have to be fitted to the mapped shape on every step
+    auto angle = qRadiansToDegrees(qAtan2(local.m12(), local.m11()));
+    auto center = mapToParent(mapFromItem(mTarget, mTarget->boundingRect().center()));
+
+    mTarget->setTransform(local * QTransform().rotate(-angle) * local.inverted() * mTarget->transform());
+    recalculate();
+    setRotationAroundCenter(rotation() + angle);
+
+    setPos(pos() + center - mapToParent(mapFromItem(mTarget, mTarget->boundingRect().center())));
+}
+
+void GraphicsItemScaler::dropTarget()
+{
+    // A target reparented by someone else is alive and gets its opacity back. One being
+    // destroyed is only a QGraphicsItem here, as ~QGraphicsItem removes it from its parent,
+    // so it is no pixmap item anymore and must not be touched
+    if (mPixmapScalingCache && qgraphicsitem_cast<QGraphicsPixmapItem *>(mTarget))
+        mTarget->setOpacity(mTargetOpacity);
+
+    delete mPixmapScalingCache;
+    mPixmapScalingCache = nullptr;
+
+    unregisterTarget();
+
+    mTarget = nullptr;
+    mTargetParent = nullptr;
+
+    // A drag in progress ends without an undo command
+    if (mInteractiveScaling)
+    {
+        mInteractiveScaling = false;
+        normalizeFrame();
+        shrinkBoundingRect();
+        mScalingChangedPending = false;
+        mScalingChangedTimer->stop();
+        emit scalingFinished();
+    }
+
+    updateContentsFlag();
+    setVisible(false);
+}
+
+void GraphicsItemScaler::unregisterTarget()
+{
+    if (!mTarget)
+        return;
+
+    // The address may be reused by a new item
+    ScalerCommand::forgetTarget(mTarget);
+    for (const auto &publisher : mMirrorPublishers)
+    {
+        if (publisher)
+            publisher->removeTarget(mTarget);
     }
 }
 
@@ -180,14 +611,163 @@ void GraphicsItemScaler::updateHandleItemPositions()
 
     for (HandleItem *i : mHandleItems)
         i->alignPosition(innerRect);
+    mRotationHandleItem->alignPosition(innerRect);
 }
 
-void GraphicsItemScaler::updateBoundingRectSize(const QSizeF& size)
+void GraphicsItemScaler::fitFrame(Qt::Corner fixedCorner)
 {
-    if (mBounds.size() != size)
+    if (!mTarget)
+        return;
+
+    // Drags only change the target transform, so the shape does not have to be mapped again
+    if (!mInteractiveScaling)
+        mTargetShapeRect = mTarget->shape().boundingRect();
+
+    auto rect = targetBoundingRect();
+    QRectF bounds(mBounds.topLeft(), (QRectF(QPointF(), rect.size()) + handleBounds).size());
+
+    if (fixedCorner == Qt::TopRightCorner || fixedCorner == Qt::BottomRightCorner)
+        bounds.moveRight(mBounds.right());
+    if (fixedCorner == Qt::BottomLeftCorner || fixedCorner == Qt::BottomRightCorner)
+        bounds.moveBottom(mBounds.bottom());
+
+    // Moving the scaler repaints all of it, so while the frame can be repainted partially
+    // it moves inside the scaler instead until the drag is finished
+    if (bounds.topLeft() != mBounds.topLeft() && !canUpdateFramePartially())
+    {
+        // The offset is in scaler coordinates, map it as a vector
+        auto offset = bounds.topLeft() - mBounds.topLeft();
+        setPos(pos() + mapToParent(offset) - mapToParent(QPointF()));
+        bounds.moveTopLeft(mBounds.topLeft());
+    }
+
+    auto diff = rect.topLeft() - (bounds.topLeft() + QPointF(handleBounds.left(), handleBounds.top()));
+
+    if (bounds != mBounds)
+        setFrameBounds(bounds);
+
+    mTarget->setPos(mTarget->pos() - diff);
+    notifyMirrorPublishers();
+}
+
+void GraphicsItemScaler::setFrameBounds(const QRectF &bounds)
+{
+    if (canUpdateFramePartially() && mBoundingRect.contains(bounds))
+    {
+        // Only the outline moves: repaint the strips along the old and the new frame
+        // instead of the whole area with all the children below it
+        updateFrame(mBounds - handleBounds);
+        mBounds = bounds;
+        updateFrame(mBounds - handleBounds);
+    }
+    else
     {
         prepareGeometryChange();
-        mBounds = QRectF(QPointF(), size);
-        updateHandleItemPositions();
+        mBounds = bounds;
+        mBoundingRect = bounds;
+
+        // Reserve some room while dragging, so the next steps can be repainted partially
+        if (canUpdateFramePartially())
+        {
+            auto dx = bounds.width() * dragReserve;
+            auto dy = bounds.height() * dragReserve;
+            mBoundingRect.adjust(-dx, -dy, dx, dy);
+        }
     }
+
+    updateHandleItemPositions();
+}
+
+void GraphicsItemScaler::updateContentsFlag()
+{
+    setFlag(ItemHasNoContents, !mBoundingRectAreaVisible && !mPixmapScalingCache);
+}
+
+void GraphicsItemScaler::normalizeFrame()
+{
+    auto offset = mBounds.topLeft();
+    if (offset.isNull())
+        return;
+
+    // Make the frame start at the origin again without moving anything in the scene: the
+    // contents move back by the offset and the scaler with its transform origin forward
+    prepareGeometryChange();
+    mBounds.translate(-offset);
+    mBoundingRect.translate(-offset);
+
+    if (mTarget)
+        mTarget->setPos(mTarget->pos() - offset);
+
+    setTransformOriginPoint(transformOriginPoint() - offset);
+    setPos(pos() + offset);
+
+    updateHandleItemPositions();
+}
+
+void GraphicsItemScaler::shrinkBoundingRect()
+{
+    if (mBoundingRect != mBounds)
+    {
+        prepareGeometryChange();
+        mBoundingRect = mBounds;
+    }
+}
+
+bool GraphicsItemScaler::canUpdateFramePartially() const
+{
+    if (!mInteractiveScaling || mPixmapScalingCache)
+        return false;
+
+    if (!boundingRectAreaVisible())
+        return true;
+
+    // An opaque or patterned interior changes with the frame size and has to be repainted
+    return mBoundingRectAreaBrush.style() == Qt::NoBrush
+        || (mBoundingRectAreaBrush.style() == Qt::SolidPattern && mBoundingRectAreaBrush.color().alpha() == 0);
+}
+
+qreal GraphicsItemScaler::frameStripWidth() const
+{
+    // Half of the pen plus a pixel for antialiasing
+    qreal width = qMax<qreal>(mBoundingRectAreaPen.widthF(), 1) / 2 + 1;
+
+    if (!mBoundingRectAreaPen.isCosmetic() || !scene())
+        return width;
+
+    // Cosmetic pen width is in device pixels, so it is the widest in the most zoomed out view
+    qreal minScale = 0;
+    for (auto view : scene()->views())
+    {
+        auto t = deviceTransform(view->viewportTransform());
+        auto origin = t.map(QPointF());
+        auto scale = qMin(QLineF(origin, t.map(QPointF(1, 0))).length(),
+                          QLineF(origin, t.map(QPointF(0, 1))).length());
+
+        if (minScale == 0 || scale < minScale)
+            minScale = scale;
+    }
+
+    return qFuzzyIsNull(minScale) ? width : width / minScale;
+}
+
+void GraphicsItemScaler::notifyMirrorPublishers()
+{
+    for (const auto &publisher : mMirrorPublishers)
+    {
+        if (publisher)
+            publisher->markDirty(this);
+    }
+}
+
+void GraphicsItemScaler::updateFrame(const QRectF &frame)
+{
+    if (!boundingRectAreaVisible())
+        return;
+
+    auto w = frameStripWidth();
+
+    update(frame.left() - w, frame.top() - w, frame.width() + 2 * w, 2 * w);
+    update(frame.left() - w, frame.bottom() - w, frame.width() + 2 * w, 2 * w);
+    update(frame.left() - w, frame.top() - w, 2 * w, frame.height() + 2 * w);
+    update(frame.right() - w, frame.top() - w, 2 * w, frame.height() + 2 * w);
 }
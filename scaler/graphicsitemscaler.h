@@ -5,6 +5,15 @@
 #include <QGraphicsItem>
 #include <QPen>
 #include <QGraphicsView>
+#include <QPointer>
+#include <QElapsedTimer>
+#include "scalerstate.h"
+
+class QUndoStack;
+class QTimer;
+class PixmapScalingCache;
+class HandleEventRecorder;
+class ScalerMirrorPublisher;
 
 class GraphicsItemScaler : public QGraphicsObject
 {
@@ -29,39 +38,145 @@ public:
     bool boundingRectAreaVisible() const;
     void setBoundingRectAreaVisible(bool visible);
 
+    // Frame with the handle margins. While the frame is dragged boundingRect() may be larger
+    // and the frame may not start at the origin
+    QRectF handlesRect() const;
+
     QGraphicsItem* target() const;
+    // Gives the current target back to its original parent and attaches the new one keeping
+    // its scene position. A scaler without a target is hidden. A handle drag in progress is
+    // finished first and the rest of it is ignored
+    void setTarget(QGraphicsItem *target);
     QRectF targetBoundingRect() const;
+    // Scaler the item is attached to as a target, if any
+    static GraphicsItemScaler *scalerOf(const QGraphicsItem *item);
+
+    bool rotationHandleVisible() const;
+    void setRotationHandleVisible(bool visible);
+
+    // Rotates the scaler around the center of the frame. Handles then scale the target
+    // along its rotated axes
+    void setRotationAroundCenter(qreal angle);
 
     bool handlersIgnoreTransformations() const;
     // If true, handler items ignore all transformations e.g. zooming the view etc
     void setHandlersIgnoreTransformations(bool ignore);
 
+    QUndoStack *undoStack() const;
+    // If set, every handle drag is pushed to the stack as a single command
+    void setUndoStack(QUndoStack *stack);
+
+    bool progressivePixmapScaling() const;
+    // If the target is a QGraphicsPixmapItem, the scaler paints it instead of the target: from
+    // a mip pyramid while dragging and from a copy rescaled in the background otherwise.
+    // The target (with its children) is made transparent while it is enabled
+    void setProgressivePixmapScaling(bool enabled);
+
+    HandleEventRecorder *handleEventRecorder() const;
+    // If set, every mouse event reaching a handle item is recorded. The recorder is not owned
+    void setHandleEventRecorder(HandleEventRecorder *recorder);
+
+    // Handle item with the given attachment flags, as stored in recorded handle events
+    QGraphicsItem *handleItem(int attachmentFlags) const;
+
+    int scalingChangedFrequency() const;
+    // Maximum number of scalingChanged() emissions per second, 0 means no limit.
+    // The last change of a drag is always emitted before scalingFinished()
+    void setScalingChangedFrequency(int frequency);
+
+    static int touchBatchInterval();
+    // Touch moves of all handles are applied together once per interval, 16 ms by default
+    static void setTouchBatchInterval(int msec);
+
     // QGraphicsItem interface
 public:
     virtual QRectF boundingRect() const override;
+    virtual QPainterPath shape() const override;
     virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
 
+protected:
+    virtual QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+
+signals:
+    void scalingStarted();
+    // Target bounding rect in scene coordinates
+    void scalingChanged(const QRectF &rect);
+    void scalingFinished();
+
 public slots:
     void recalculate();
 
+private slots:
+    void emitScalingChanged();
+
 private:
     class HandleItem;
-
+    class RotationHandleItem;
+    friend class ScalerMirrorPublisher;
+    friend class HandlerStrategy;
+    friend struct ScalerState;
+
+    void attachTarget();
+    void releaseTarget();
+    // Moves the rotation of the target into the scaler, keeping the target center in place
+    void adoptTargetRotation();
+    void dropTarget();
+    // Removes the target from undo commands and mirror publishers before it is destroyed
+    void unregisterTarget();
     void updateHandleItemPositions();
-    void updateBoundingRectSize(const QSizeF &size);
+    // Fits the frame to the target keeping the given corner of the frame in place
+    void fitFrame(Qt::Corner fixedCorner);
+    void setFrameBounds(const QRectF &bounds);
+    void updateContentsFlag();
+    void normalizeFrame();
+    void shrinkBoundingRect();
+    void notifyMirrorPublishers();
+
+    bool canUpdateFramePartially() const;
+    qreal frameStripWidth() const;
+    void updateFrame(const QRectF &frame);
+
+    // Called by handle items when a drag starts and ends
+    void beginInteractiveScaling();
+    void endInteractiveScaling();
+    // Restores the geometry from the start of the drag without an undo command
+    void cancelInteractiveScaling();
+    void notifyScalingChanged();
 
     QList<HandleItem *> mHandleItems;
+    RotationHandleItem *mRotationHandleItem;
     QPen mHandleItemPen;
     QBrush mHandleItemBrush;
 
     QGraphicsItem* mTarget;
+    QGraphicsItem* mTargetParent;
+    bool mTargetMovable;
+    // Shape bounds in target coordinates, not refreshed during drags
+    QRectF mTargetShapeRect;
+    // Starts at the origin, except during drags of the left and top handles
     QRectF mBounds;
+    QRectF mBoundingRect;
 
     bool mBoundingRectAreaVisible;
     QPen mBoundingRectAreaPen;
     QBrush mBoundingRectAreaBrush;
 
     bool mHandlersIgnoreTransformations;
+
+    QPointer<QUndoStack> mUndoStack;
+    bool mInteractiveScaling;
+    ScalerState mScalingStartState;
+
+    PixmapScalingCache *mPixmapScalingCache;
+    qreal mTargetOpacity;
+
+    HandleEventRecorder *mHandleEventRecorder;
+    QList<QPointer<ScalerMirrorPublisher>> mMirrorPublishers;
+
+    int mScalingChangedFrequency;
+    bool mScalingChangedPending;
+    QTimer *mScalingChangedTimer;
+    QElapsedTimer mScalingChangedClock;
 };
 
 #endif // GRAPHICSITEMRESIZER_H
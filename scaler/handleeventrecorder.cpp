@@ -0,0 +1,180 @@
+#include "handleeventrecorder.h"
+#include "graphicsitemscaler.h"
+
+#include <QDataStream>
+#include <QGraphicsSceneMouseEvent>
+#include <QIODevice>
+
+static const quint32 fileMagic = 0x47495352; // "GISR"
+static const quint16 fileVersion = 2;
+// Type, attachment, modifiers, timestamp delta and six doubles
+static const qint64 eventRecordSize = 1 + 1 + 4 + 4 + 6 * 8;
+
+static void writeState(QDataStream &stream, const ScalerState &state)
+{
+    stream << state.targetTransform << state.targetSceneTransform << quint8(state.attached)
+           << state.pos << state.rotation << state.transformOrigin;
+}
+
+static void readState(QDataStream &stream, ScalerState *state)
+{
+    quint8 attached = 0;
+    stream >> state->targetTransform >> state->targetSceneTransform >> attached
+           >> state->pos >> state->rotation >> state->transformOrigin;
+    state->attached = attached != 0;
+}
+
+HandleEventRecorder::HandleEventRecorder()
+{
+
+}
+
+void HandleEventRecorder::clear()
+{
+    mSession = HandleSession();
+    mClock.invalidate();
+}
+
+void HandleEventRecorder::record(const GraphicsItemScaler *scaler, HandleEvent::Type type, int attachment,
+                                 const QGraphicsSceneMouseEvent *event)
+{
+    Q_ASSERT(event);
+
+    record(scaler, type, attachment, event->pos(), event->scenePos(), event->lastScenePos(), event->modifiers());
+}
+
+void HandleEventRecorder::record(const GraphicsItemScaler *scaler, HandleEvent::Type type, int attachment,
+                                 const QPointF &pos, const QPointF &scenePos, const QPointF &lastScenePos,
+                                 Qt::KeyboardModifiers modifiers)
+{
+    Q_ASSERT(scaler);
+
+    if (!mClock.isValid())
+        mClock.start();
+
+    // Handles record before they act, so this is the geometry the session starts from
+    if (mSession.events.isEmpty() && scaler->target())
+    {
+        mSession.hasInitialState = true;
+        mSession.initialState = ScalerState::capture(scaler->target());
+        mSession.targetRect = scaler->target()->boundingRect();
+    }
+
+    HandleEvent e;
+    e.type = type;
+    e.attachment = attachment;
+    e.modifiers = quint32(modifiers);
+    e.timestamp = mClock.nsecsElapsed() / 1000;
+    e.pos = pos;
+    e.scenePos = scenePos;
+    e.lastScenePos = lastScenePos;
+
+    mSession.events.append(e);
+}
+
+const QVector<HandleEvent> &HandleEventRecorder::events() const
+{
+    return mSession.events;
+}
+
+const HandleSession &HandleEventRecorder::session() const
+{
+    return mSession;
+}
+
+bool HandleEventRecorder::save(QIODevice *device) const
+{
+    Q_ASSERT(device);
+
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << fileMagic << fileVersion << quint8(mSession.hasInitialState);
+    if (mSession.hasInitialState)
+        writeState(stream, mSession.initialState);
+    stream << mSession.targetRect << quint32(mSession.events.size());
+
+    qint64 previous = 0;
+    for (const auto &e : mSession.events)
+    {
+        stream << quint8(e.type) << quint8(e.attachment) << e.modifiers
+               << quint32(e.timestamp - previous)
+               << e.pos.x() << e.pos.y()
+               << e.scenePos.x() << e.scenePos.y()
+               << e.lastScenePos.x() << e.lastScenePos.y();
+        previous = e.timestamp;
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+bool HandleEventRecorder::load(QIODevice *device, HandleSession *session)
+{
+    Q_ASSERT(device);
+    Q_ASSERT(session);
+
+    QDataStream stream(device);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    stream >> magic >> version;
+
+    if (stream.status() != QDataStream::Ok || magic != fileMagic || version < 1 || version > fileVersion)
+        return false;
+
+    *session = HandleSession();
+
+    if (version >= 2)
+    {
+        quint8 hasInitialState = 0;
+        stream >> hasInitialState;
+        if (hasInitialState)
+            readState(stream, &session->initialState);
+        stream >> session->targetRect;
+        session->hasInitialState = hasInitialState != 0;
+    }
+
+    quint32 count = 0;
+    stream >> count;
+
+    if (stream.status() != QDataStream::Ok)
+        return false;
+
+    // The count comes from the file, it must not decide how much memory is taken
+    if (!device->isSequential())
+    {
+        if (count > quint64(device->bytesAvailable()) / eventRecordSize)
+            return false;
+        session->events.reserve(int(count));
+    }
+
+    qint64 timestamp = 0;
+    for (quint32 i = 0; i < count; ++i)
+    {
+        quint8 type, attachment;
+        quint32 modifiers, delta;
+        qreal x, y, sceneX, sceneY, lastSceneX, lastSceneY;
+
+        stream >> type >> attachment >> modifiers >> delta
+               >> x >> y >> sceneX >> sceneY >> lastSceneX >> lastSceneY;
+
+        if (stream.status() != QDataStream::Ok || type > HandleEvent::Cancel)
+            return false;
+
+        timestamp += delta;
+
+        HandleEvent e;
+        e.type = HandleEvent::Type(type);
+        e.attachment = attachment;
+        e.modifiers = modifiers;
+        e.timestamp = timestamp;
+        e.pos = QPointF(x, y);
+        e.scenePos = QPointF(sceneX, sceneY);
+        e.lastScenePos = QPointF(lastSceneX, lastSceneY);
+
+        session->events.append(e);
+    }
+
+    return true;
+}
@@ -0,0 +1,77 @@
+#ifndef HANDLEEVENTRECORDER_H
+#define HANDLEEVENTRECORDER_H
+
+#include <QElapsedTimer>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+#include "scalerstate.h"
+
+class QGraphicsSceneMouseEvent;
+class QIODevice;
+class GraphicsItemScaler;
+
+// A mouse event as it reached a handle item
+struct HandleEvent
+{
+    enum Type
+    {
+        Press,
+        Move,
+        Release,
+        // Touch cancellation, the drag is undone
+        Cancel
+    };
+
+    Type type;
+    int attachment;
+    quint32 modifiers;
+    // Microseconds since the start of the session
+    qint64 timestamp;
+    // In handle coordinates
+    QPointF pos;
+    QPointF scenePos;
+    QPointF lastScenePos;
+};
+
+// Events of a session with the geometry they started from, so a replay ends up with
+// exactly the recorded geometry
+struct HandleSession
+{
+    bool hasInitialState = false;
+    ScalerState initialState;
+    // Bounding rect of the target in its own coordinates, to create a stand-in target
+    QRectF targetRect;
+    QVector<HandleEvent> events;
+};
+
+// Captures the handle events of a scaler, see GraphicsItemScaler::setHandleEventRecorder().
+// Sessions are saved in a compact binary form: positions are kept as doubles to replay
+// the exact geometry, timestamps are stored as deltas.
+class HandleEventRecorder
+{
+public:
+    HandleEventRecorder();
+
+    // Drops the recorded events, the clock starts again with the next event and the
+    // geometry of the scaler is taken again
+    void clear();
+    void record(const GraphicsItemScaler *scaler, HandleEvent::Type type, int attachment,
+                const QGraphicsSceneMouseEvent *event);
+    // For input which is not a mouse event, e.g. batched touch points
+    void record(const GraphicsItemScaler *scaler, HandleEvent::Type type, int attachment, const QPointF &pos,
+                const QPointF &scenePos, const QPointF &lastScenePos, Qt::KeyboardModifiers modifiers);
+
+    const QVector<HandleEvent> &events() const;
+    const HandleSession &session() const;
+
+    bool save(QIODevice *device) const;
+    // Files of the first version have no initial state
+    static bool load(QIODevice *device, HandleSession *session);
+
+private:
+    QElapsedTimer mClock;
+    HandleSession mSession;
+};
+
+#endif // HANDLEEVENTRECORDER_H
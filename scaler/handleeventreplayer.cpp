@@ -0,0 +1,145 @@
+#include "handleeventreplayer.h"
+
+#include <QGraphicsScene>
+#include <QGraphicsSceneMouseEvent>
+#include <QTimer>
+#include <QTouchEvent>
+
+HandleEventReplayer::HandleEventReplayer(GraphicsItemScaler *scaler, QObject *parent)
+    : QObject(parent)
+    , mScaler(scaler)
+    , mNext(0)
+    , mRunning(false)
+    , mTimer(new QTimer(this))
+{
+    Q_ASSERT(mScaler);
+
+    mTimer->setSingleShot(true);
+    mTimer->setTimerType(Qt::PreciseTimer);
+    connect(mTimer, &QTimer::timeout, this, &HandleEventReplayer::replayDueEvents);
+}
+
+void HandleEventReplayer::setEvents(const QVector<HandleEvent> &events)
+{
+    Q_ASSERT(!mRunning);
+    mSession = HandleSession();
+    mSession.events = events;
+}
+
+void HandleEventReplayer::setSession(const HandleSession &session)
+{
+    Q_ASSERT(!mRunning);
+    mSession = session;
+}
+
+void HandleEventReplayer::start(HandleEventReplayer::Timing timing)
+{
+    stop();
+
+    mNext = 0;
+    mDurations.clear();
+    mDurations.reserve(mSession.events.size());
+    mRunning = true;
+
+    if (mSession.hasInitialState && mScaler && mScaler->target())
+        mSession.initialState.applyTo(mScaler->target());
+
+    if (timing == AsFastAsPossible)
+    {
+        while (mRunning && mNext < mSession.events.size())
+            deliver(mSession.events.at(mNext++));
+
+        mRunning = false;
+        emit finished();
+        return;
+    }
+
+    mClock.start();
+    replayDueEvents();
+}
+
+void HandleEventReplayer::stop()
+{
+    mTimer->stop();
+    mRunning = false;
+}
+
+bool HandleEventReplayer::isRunning() const
+{
+    return mRunning;
+}
+
+const QVector<qint64> &HandleEventReplayer::eventDurations() const
+{
+    return mDurations;
+}
+
+void HandleEventReplayer::replayDueEvents()
+{
+    if (!mRunning)
+        return;
+
+    auto start = mSession.events.isEmpty() ? 0 : mSession.events.first().timestamp;
+    auto elapsed = mClock.nsecsElapsed() / 1000;
+
+    while (mRunning && mNext < mSession.events.size() && mSession.events.at(mNext).timestamp - start <= elapsed)
+        deliver(mSession.events.at(mNext++));
+
+    if (!mRunning)
+        return;
+
+    if (mNext < mSession.events.size())
+    {
+        auto wait = (mSession.events.at(mNext).timestamp - start - mClock.nsecsElapsed() / 1000) / 1000;
+        mTimer->start(int(qMax<qint64>(0, wait)));
+    }
+    else
+    {
+        mRunning = false;
+        emit finished();
+    }
+}
+
+void HandleEventReplayer::deliver(const HandleEvent &event)
+{
+    if (!mScaler || !mScaler->scene())
+    {
+        stop();
+        return;
+    }
+
+    auto handle = mScaler->handleItem(event.attachment);
+    if (!handle)
+        return;
+
+    QElapsedTimer timer;
+
+    if (event.type == HandleEvent::Cancel)
+    {
+        QTouchEvent touchEvent(QEvent::TouchCancel);
+        touchEvent.setModifiers(Qt::KeyboardModifiers(event.modifiers));
+
+        timer.start();
+        mScaler->scene()->sendEvent(handle, &touchEvent);
+        mDurations.append(timer.nsecsElapsed());
+        return;
+    }
+
+    QEvent::Type type = QEvent::GraphicsSceneMouseMove;
+    if (event.type == HandleEvent::Press)
+        type = QEvent::GraphicsSceneMousePress;
+    else if (event.type == HandleEvent::Release)
+        type = QEvent::GraphicsSceneMouseRelease;
+
+    QGraphicsSceneMouseEvent mouseEvent(type);
+    mouseEvent.setPos(event.pos);
+    mouseEvent.setScenePos(event.scenePos);
+    mouseEvent.setLastScenePos(event.lastScenePos);
+    mouseEvent.setModifiers(Qt::KeyboardModifiers(event.modifiers));
+    mouseEvent.setButton(event.type == HandleEvent::Move ? Qt::NoButton : Qt::LeftButton);
+    mouseEvent.setButtons(event.type == HandleEvent::Release ? Qt::NoButton : Qt::LeftButton);
+
+    timer.start();
+    mScaler->scene()->sendEvent(handle, &mouseEvent);
+    mDurations.append(timer.nsecsElapsed());
+}
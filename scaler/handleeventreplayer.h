@@ -0,0 +1,59 @@
+#ifndef HANDLEEVENTREPLAYER_H
+#define HANDLEEVENTREPLAYER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QVector>
+#include "graphicsitemscaler.h"
+#include "handleeventrecorder.h"
+
+class QTimer;
+
+// Feeds recorded handle events back to the handles of a scaler. The scaler has to be
+// in a scene, which does not need to be shown in a view. A session with an initial state
+// sets the target geometry first, the target should match the recorded target rect.
+class HandleEventReplayer : public QObject
+{
+    Q_OBJECT
+public:
+    enum Timing
+    {
+        // Events are delivered from the event loop at their recorded times
+        OriginalTiming,
+        // Events are delivered synchronously one after another
+        AsFastAsPossible
+    };
+
+    explicit HandleEventReplayer(GraphicsItemScaler *scaler, QObject *parent = nullptr);
+
+    void setEvents(const QVector<HandleEvent> &events);
+    void setSession(const HandleSession &session);
+
+    void start(Timing timing = AsFastAsPossible);
+    void stop();
+    bool isRunning() const;
+
+    // Time spent delivering each event, in nanoseconds
+    const QVector<qint64> &eventDurations() const;
+
+signals:
+    void finished();
+
+private slots:
+    void replayDueEvents();
+
+private:
+    void deliver(const HandleEvent &event);
+
+    QPointer<GraphicsItemScaler> mScaler;
+    HandleSession mSession;
+    QVector<qint64> mDurations;
+    int mNext;
+    bool mRunning;
+
+    QTimer *mTimer;
+    QElapsedTimer mClock;
+};
+
+#endif // HANDLEEVENTREPLAYER_H
@@ -1,23 +1,33 @@
 #include "handleitem.h"
 #include "handlerstrategies.h"
+#include "handleeventrecorder.h"
 
 #include <QBrush>
+#include <QCoreApplication>
 #include <QCursor>
 #include <QGraphicsSceneMouseEvent>
+#include <QTimer>
+#include <QTouchEvent>
 #include <QDebug>
 #include <QtMath>
 
 QHash<int, QWeakPointer<HandlerStrategy>> GraphicsItemScaler::HandleItem::Strategies;
+QList<GraphicsItemScaler::HandleItem *> GraphicsItemScaler::HandleItem::PendingTouchHandles;
+QTimer *GraphicsItemScaler::HandleItem::TouchBatchTimer = nullptr;
+int GraphicsItemScaler::HandleItem::TouchBatchInterval = 16;
 
 GraphicsItemScaler::HandleItem::HandleItem(int attachmentFlags, const QRectF &rect, GraphicsItemScaler *scaler)
     : QGraphicsRectItem(rect, scaler)
     , mScaler(scaler)
     , mHandleMoveAsResize(false)
+    , mTouchPointId(-1)
+    , mTouchPending(false)
 {
     mAttachmentFlags = cleanAttachment(attachmentFlags);
 
     setFlag(ItemIsSelectable);
     setAcceptedMouseButtons(Qt::LeftButton);
+    setAcceptTouchEvents(true);
 
     setBrush(QBrush(Qt::black));
     setCursor(getCursor(mAttachmentFlags));
@@ -32,11 +42,27 @@ GraphicsItemScaler::HandleItem::HandleItem(int attachmentFlags, const QSizeF &si
 
 }
 
+GraphicsItemScaler::HandleItem::~HandleItem()
+{
+    PendingTouchHandles.removeOne(this);
+}
+
 void GraphicsItemScaler::HandleItem::alignPosition(const QRectF &resizerRect)
 {
     QPointF newPos = resizerRect.center();
     mStrategy->alignHandlerPosition(&newPos, resizerRect);
     setPos(newPos);
+
+    // Keep the handle outside of the frame when the parent rotation is ignored
+    setRotation(flags() & ItemIgnoresTransformations ? scaler()->rotation() : 0);
+}
+
+void GraphicsItemScaler::HandleItem::abortDrag()
+{
+    mHandleMoveAsResize = false;
+    mTouchPointId = -1;
+    mTouchPending = false;
+    PendingTouchHandles.removeOne(this);
 }
 
 GraphicsItemScaler *GraphicsItemScaler::HandleItem::scaler() const
@@ -153,26 +179,226 @@ QSharedPointer<HandlerStrategy> GraphicsItemScaler::HandleItem::getStrategy(int
 
 void GraphicsItemScaler::HandleItem::mousePressEvent(QGraphicsSceneMouseEvent *event)
 {
+    if (auto recorder = scaler()->handleEventRecorder())
+        recorder->record(scaler(), HandleEvent::Press, mAttachmentFlags, event);
+
+    // The scaler is already driven by a touch point or another handle
+    if (scaler()->mInteractiveScaling)
+    {
+        event->ignore();
+        return;
+    }
+
     mHandleMoveAsResize = true;
+    scaler()->beginInteractiveScaling();
     event->accept();
 }
 
 void GraphicsItemScaler::HandleItem::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
 {
+    if (auto recorder = scaler()->handleEventRecorder())
+        recorder->record(scaler(), HandleEvent::Move, mAttachmentFlags, event);
+
     if (!mHandleMoveAsResize)
     {
         event->ignore();
         return;
     }
 
-    auto offset   = event->scenePos() - event->lastScenePos();
-    auto pointPos = HandlerStrategy::PointPosition(event->pos(), boundingRect());
-
-    mStrategy->solveConstraints(scaler(), pointPos, offset);
+    resizeTo(event->pos(), event->scenePos(), event->lastScenePos());
 }
 
 void GraphicsItemScaler::HandleItem::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
 {
+    if (auto recorder = scaler()->handleEventRecorder())
+        recorder->record(scaler(), HandleEvent::Release, mAttachmentFlags, event);
+
     event->setAccepted(mHandleMoveAsResize);
+
+    if (mHandleMoveAsResize)
+        scaler()->endInteractiveScaling();
+
+    mHandleMoveAsResize = false;
+}
+
+bool GraphicsItemScaler::HandleItem::sceneEvent(QEvent *event)
+{
+    switch (event->type())
+    {
+    case QEvent::TouchBegin:
+        return touchBeginEvent(static_cast<QTouchEvent *>(event));
+    case QEvent::TouchUpdate:
+        return touchUpdateEvent(static_cast<QTouchEvent *>(event));
+    case QEvent::TouchEnd:
+        touchEndEvent(static_cast<QTouchEvent *>(event));
+        return true;
+    case QEvent::TouchCancel:
+        cancelDrag();
+        return true;
+    default:
+        return QGraphicsRectItem::sceneEvent(event);
+    }
+}
+
+void GraphicsItemScaler::HandleItem::resizeTo(const QPointF &pos, const QPointF &scenePos, const QPointF &lastScenePos)
+{
+    // The target was destroyed during the drag
+    if (!scaler()->target())
+        return;
+
+    // In scaler coordinates, so a rotated scaler scales along its own axes
+    auto offset   = scaler()->mapFromScene(scenePos) - scaler()->mapFromScene(lastScenePos);
+    auto pointPos = HandlerStrategy::PointPosition(pos, boundingRect());
+
+    mStrategy->solveConstraints(scaler(), pointPos, offset);
+    scaler()->notifyScalingChanged();
+}
+
+bool GraphicsItemScaler::HandleItem::touchBeginEvent(QTouchEvent *event)
+{
+    // Every scaler is driven by a single touch point or the mouse at a time
+    if (scaler()->mInteractiveScaling || event->touchPoints().isEmpty())
+    {
+        event->ignore();
+        return false;
+    }
+
+    auto point = event->touchPoints().first();
+
+    mTouchPointId = point.id();
+    mTouchPos = point.pos();
+    mTouchScenePos = point.scenePos();
+    mTouchModifiers = event->modifiers();
+
+    if (auto recorder = scaler()->handleEventRecorder())
+        recorder->record(scaler(), HandleEvent::Press, mAttachmentFlags, point.pos(), point.scenePos(), point.lastScenePos(), mTouchModifiers);
+
+    scaler()->beginInteractiveScaling();
+    event->accept();
+    return true;
+}
+
+bool GraphicsItemScaler::HandleItem::touchUpdateEvent(QTouchEvent *event)
+{
+    if (mTouchPointId < 0)
+        return false;
+
+    for (const auto &point : event->touchPoints())
+    {
+        if (point.id() != mTouchPointId)
+            continue;
+
+        if (point.state() == Qt::TouchPointReleased)
+        {
+            moveTouchPoint(point, event->modifiers());
+            finishTouch();
+        }
+        else if (point.state() == Qt::TouchPointMoved)
+        {
+            moveTouchPoint(point, event->modifiers());
+
+            if (!TouchBatchTimer)
+            {
+                TouchBatchTimer = new QTimer(QCoreApplication::instance());
+                TouchBatchTimer->setSingleShot(true);
+                TouchBatchTimer->setInterval(TouchBatchInterval);
+                QObject::connect(TouchBatchTimer, &QTimer::timeout, &HandleItem::flushTouchBatch);
+            }
+
+            if (!TouchBatchTimer->isActive())
+                TouchBatchTimer->start();
+        }
+        break;
+    }
+
+    event->accept();
+    return true;
+}
+
+void GraphicsItemScaler::HandleItem::touchEndEvent(QTouchEvent *event)
+{
+    for (const auto &point : event->touchPoints())
+    {
+        if (point.id() == mTouchPointId)
+        {
+            moveTouchPoint(point, event->modifiers());
+            break;
+        }
+    }
+
+    finishTouch();
+}
+
+void GraphicsItemScaler::HandleItem::moveTouchPoint(const QTouchEvent::TouchPoint &point, Qt::KeyboardModifiers modifiers)
+{
+    // A release may come at a position no move has reported yet
+    if (point.scenePos() == mTouchScenePos)
+        return;
+
+    // The first position of the frame is the start of the accumulated move
+    if (!mTouchPending)
+    {
+        mTouchPending = true;
+        mTouchLastScenePos = mTouchScenePos;
+        PendingTouchHandles.append(this);
+    }
+
+    mTouchPos = point.pos();
+    mTouchScenePos = point.scenePos();
+    mTouchModifiers = modifiers;
+}
+
+void GraphicsItemScaler::HandleItem::finishTouch()
+{
+    if (mTouchPointId < 0)
+        return;
+
+    applyPendingTouch();
+
+    if (auto recorder = scaler()->handleEventRecorder())
+        recorder->record(scaler(), HandleEvent::Release, mAttachmentFlags, mTouchPos, mTouchScenePos, mTouchScenePos, mTouchModifiers);
+
+    mTouchPointId = -1;
+    scaler()->endInteractiveScaling();
+}
+
+void GraphicsItemScaler::HandleItem::applyPendingTouch()
+{
+    if (!mTouchPending)
+        return;
+
+    mTouchPending = false;
+    PendingTouchHandles.removeOne(this);
+
+    // Recorded as a single move, so the session can be replayed with mouse events
+    if (auto recorder = scaler()->handleEventRecorder())
+        recorder->record(scaler(), HandleEvent::Move, mAttachmentFlags, mTouchPos, mTouchScenePos, mTouchLastScenePos, mTouchModifiers);
+
+    resizeTo(mTouchPos, mTouchScenePos, mTouchLastScenePos);
+}
+
+void GraphicsItemScaler::HandleItem::flushTouchBatch()
+{
+    auto handles = PendingTouchHandles;
+    PendingTouchHandles.clear();
+
+    for (auto handle : handles)
+        handle->applyPendingTouch();
+}
+
+void GraphicsItemScaler::HandleItem::cancelDrag()
+{
+    if (mTouchPointId < 0 && !mHandleMoveAsResize)
+        return;
+
+    // Moves not applied yet are dropped with the rest of the drag
+    mTouchPending = false;
+    PendingTouchHandles.removeOne(this);
+
+    if (auto recorder = scaler()->handleEventRecorder())
+        recorder->record(scaler(), HandleEvent::Cancel, mAttachmentFlags, mTouchPos, mTouchScenePos, mTouchScenePos, mTouchModifiers);
+
+    mTouchPointId = -1;
     mHandleMoveAsResize = false;
+    scaler()->cancelInteractiveScaling();
 }
@@ -3,6 +3,7 @@
 
 #include "graphicsitemscaler.h"
 #include <QGraphicsRectItem>
+#include <QTouchEvent>
 
 class HandlerStrategy;
 class GraphicsItemScaler::HandleItem : public QGraphicsRectItem
@@ -23,6 +24,7 @@ public:
 
     explicit HandleItem(int attachmentFlags, const QRectF &rect, GraphicsItemScaler *scaler);
     explicit HandleItem(int attachmentFlags, const QSizeF &size, GraphicsItemScaler *scaler);
+    ~HandleItem();
 
     int attachmentFlags() const
     {
@@ -30,16 +32,32 @@ public:
     }
 
     void alignPosition(const QRectF &resizerRect);
+    // Forgets a drag in progress without touching the scaler, later events of it are ignored
+    void abortDrag();
 
     // QGraphicsItem interface
 protected:
     virtual void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
     virtual void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
     virtual void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
+    virtual bool sceneEvent(QEvent *event) override;
 
 private:
     GraphicsItemScaler *scaler() const;
 
+    void resizeTo(const QPointF &pos, const QPointF &scenePos, const QPointF &lastScenePos);
+
+    bool touchBeginEvent(QTouchEvent *event);
+    bool touchUpdateEvent(QTouchEvent *event);
+    void touchEndEvent(QTouchEvent *event);
+    // Takes the position of the touch point into the move applied with the next batch
+    void moveTouchPoint(const QTouchEvent::TouchPoint &point, Qt::KeyboardModifiers modifiers);
+    // Applies the pending move and ends the drag
+    void finishTouch();
+    void applyPendingTouch();
+    // Ends a touch or mouse drag, restoring the geometry it started from
+    void cancelDrag();
+
     QRectF handlerRect(int attachment, const QSizeF &size) const;
 
     GraphicsItemScaler *mScaler;
@@ -47,10 +65,26 @@ private:
     bool mHandleMoveAsResize;
     HandlerStrategyPointer mStrategy;
 
+    // Touch point driving the handle, -1 if none
+    int mTouchPointId;
+    bool mTouchPending;
+    QPointF mTouchPos;
+    QPointF mTouchScenePos;
+    QPointF mTouchLastScenePos;
+    Qt::KeyboardModifiers mTouchModifiers;
+
     static int cleanAttachment(int attachment);
     static Qt::CursorShape getCursor(int attachment);
     static HandlerStrategyPointer getStrategy(int attachment);
     static QHash<int, QWeakPointer<HandlerStrategy>> Strategies;
+
+    // Touch moves of all handles are collected and applied together once per frame
+    static void flushTouchBatch();
+    static QList<HandleItem *> PendingTouchHandles;
+    static QTimer *TouchBatchTimer;
+    static int TouchBatchInterval;
+
+    friend class GraphicsItemScaler;
 };
 
 #endif // HANDLEITEM_H
@@ -21,7 +21,6 @@ void HandlerStrategy::alignHandlerPosition(QPointF *position, const QRectF &boun
 
 void HandlerStrategy::scaleTargetItem(GraphicsItemScaler *resizer, const QMarginsF &margins) const
 {
-    auto leftOrTop  = !qFuzzyIsNull(margins.left()) || !qFuzzyIsNull(margins.top());
     auto horizontal = !qFuzzyIsNull(margins.left()) || !qFuzzyIsNull(margins.right());
     auto vertical   = !qFuzzyIsNull(margins.top()) || !qFuzzyIsNull(margins.bottom());
 
@@ -57,15 +56,11 @@ void HandlerStrategy::scaleTargetItem(GraphicsItemScaler *resizer, const QMargin
 
     target->setTransform(QTransform(m11, m12, m13, m21, m22, m23, m31, m32, m33));
 
-    if (leftOrTop)
-    {
-        auto before = resizer->boundingRect().size();
-        resizer->recalculate();
-        auto after  = resizer->boundingRect().size();
-
-        auto diff = QPointF(before.width() - after.width(), before.height() - after.height());
-        resizer->setPos(resizer->pos() + diff);
-    }
+    // The opposite side of the frame stays where it is
+    if (!qFuzzyIsNull(margins.left()))
+        resizer->fitFrame(Qt::TopRightCorner);
+    else if (!qFuzzyIsNull(margins.top()))
+        resizer->fitFrame(Qt::BottomLeftCorner);
     else
         resizer->recalculate();
 }
@@ -0,0 +1,154 @@
+#include "pixmapscalingcache.h"
+
+#include <QGraphicsPixmapItem>
+#include <QPainter>
+#include <QtConcurrent>
+
+// Levels smaller than that are not worth keeping
+static const int minimumLevelSize = 64;
+
+PixmapScalingCache::PixmapScalingCache(QGraphicsPixmapItem *item, QObject *parent)
+    : QObject(parent)
+    , mItem(item)
+    , mCacheKey(0)
+    , mLevelsKey(0)
+    , mRescaleKey(0)
+{
+    Q_ASSERT(mItem);
+
+    connect(&mLevelsWatcher, &QFutureWatcher<QVector<QImage>>::finished, this, &PixmapScalingCache::onLevelsFinished);
+    connect(&mRescaleWatcher, &QFutureWatcher<QImage>::finished, this, &PixmapScalingCache::onRescaleFinished);
+}
+
+void PixmapScalingCache::paint(QPainter *painter, bool interactive)
+{
+    Q_ASSERT(painter);
+
+    auto pixmap = mItem->pixmap();
+    if (pixmap.isNull())
+        return;
+
+    if (pixmap.cacheKey() != mCacheKey)
+        reset(pixmap.cacheKey());
+
+    QRectF rect(mItem->offset(), pixmap.size() / pixmap.devicePixelRatio());
+    auto transform = painter->transform();
+    auto deviceRect = transform.mapRect(rect);
+
+    painter->save();
+
+    if (interactive)
+    {
+        // The smallest level which is still not smaller than the device rect
+        const QImage *level = nullptr;
+        for (const auto &l : mLevels)
+        {
+            if (l.width() < deviceRect.width() || l.height() < deviceRect.height())
+                break;
+            level = &l;
+        }
+
+        painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+
+        if (level)
+            painter->drawImage(rect, *level, level->rect());
+        else
+            painter->drawPixmap(rect, pixmap, pixmap.rect());
+    }
+    else
+    {
+        // The rescaled copy can only be drawn 1:1 on the device, without rotation or mirroring.
+        // It is only made smaller than the source: a zoomed in copy would take far more memory
+        // and smooth filtering of the source does as well there
+        auto size = deviceRect.size().toSize();
+        auto useRescaled = transform.type() <= QTransform::TxScale && transform.m11() > 0 && transform.m22() > 0
+                        && size.width() <= pixmap.width() && size.height() <= pixmap.height();
+
+        if (useRescaled && !mRescaled.isNull() && mRescaled.size() == size)
+        {
+            painter->setWorldTransform(QTransform());
+            painter->drawImage(deviceRect.topLeft().toPoint(), mRescaled);
+        }
+        else
+        {
+            painter->setRenderHint(QPainter::SmoothPixmapTransform,
+                                   mItem->transformationMode() == Qt::SmoothTransformation);
+            painter->drawPixmap(rect, pixmap, pixmap.rect());
+
+            if (useRescaled)
+                requestRescale(size);
+        }
+    }
+
+    painter->restore();
+}
+
+void PixmapScalingCache::onLevelsFinished()
+{
+    // The pixmap was replaced while the levels were built
+    if (mLevelsKey != mCacheKey)
+    {
+        requestLevels();
+        return;
+    }
+
+    mLevels = mLevelsWatcher.result();
+    emit changed();
+}
+
+void PixmapScalingCache::onRescaleFinished()
+{
+    // A copy of a replaced pixmap is dropped, the repaint requests a new one
+    if (mRescaleKey == mCacheKey)
+        mRescaled = mRescaleWatcher.result();
+
+    emit changed();
+}
+
+void PixmapScalingCache::reset(qint64 cacheKey)
+{
+    mCacheKey = cacheKey;
+    mLevels.clear();
+    mRescaled = QImage();
+
+    requestLevels();
+}
+
+void PixmapScalingCache::requestLevels()
+{
+    // Requested again when the running build is finished
+    if (mLevelsWatcher.isRunning())
+        return;
+
+    // A raster pixmap shares its image, so no copy of the source is made or kept here
+    mLevelsKey = mCacheKey;
+    mLevelsWatcher.setFuture(QtConcurrent::run(&PixmapScalingCache::buildLevels, mItem->pixmap().toImage()));
+}
+
+void PixmapScalingCache::requestRescale(const QSize &size)
+{
+    // The next paint after the running rescale is finished requests the current size again
+    if (size.isEmpty() || mRescaleWatcher.isRunning())
+        return;
+
+    mRescaleKey = mCacheKey;
+    mRescaleWatcher.setFuture(QtConcurrent::run(&PixmapScalingCache::rescale, mItem->pixmap().toImage(), size));
+}
+
+QVector<QImage> PixmapScalingCache::buildLevels(const QImage &image)
+{
+    QVector<QImage> levels;
+
+    auto level = image;
+    while (level.width() / 2 >= minimumLevelSize && level.height() / 2 >= minimumLevelSize)
+    {
+        level = level.scaled(level.size() / 2, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        levels.append(level);
+    }
+    return levels;
+}
+
+QImage PixmapScalingCache::rescale(const QImage &image, const QSize &size)
+{
+    return image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+}
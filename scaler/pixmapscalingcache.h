@@ -0,0 +1,54 @@
+#ifndef PIXMAPSCALINGCACHE_H
+#define PIXMAPSCALINGCACHE_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QVector>
+
+class QGraphicsPixmapItem;
+class QPainter;
+
+// Paints a pixmap item cheaply while it is being scaled. During a drag the nearest level
+// of a mip pyramid is drawn with fast filtering. Otherwise, when it is shown smaller than
+// the source, a copy rescaled to the device size is drawn. Both are made on worker threads,
+// the source pixmap is drawn until they are ready and when the item is zoomed in.
+class PixmapScalingCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PixmapScalingCache(QGraphicsPixmapItem *item, QObject *parent = nullptr);
+
+    // The painter has to be transformed to the item coordinates
+    void paint(QPainter *painter, bool interactive);
+
+signals:
+    // A level or a rescaled copy got ready, the item should be repainted
+    void changed();
+
+private slots:
+    void onLevelsFinished();
+    void onRescaleFinished();
+
+private:
+    void reset(qint64 cacheKey);
+    void requestLevels();
+    void requestRescale(const QSize &size);
+
+    static QVector<QImage> buildLevels(const QImage &image);
+    static QImage rescale(const QImage &image, const QSize &size);
+
+    QGraphicsPixmapItem *mItem;
+    qint64 mCacheKey;
+
+    // Halved step by step, starting with the half of the source pixmap
+    QVector<QImage> mLevels;
+    qint64 mLevelsKey;
+    QFutureWatcher<QVector<QImage>> mLevelsWatcher;
+
+    QImage mRescaled;
+    qint64 mRescaleKey;
+    QFutureWatcher<QImage> mRescaleWatcher;
+};
+
+#endif // PIXMAPSCALINGCACHE_H
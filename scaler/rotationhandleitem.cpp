@@ -0,0 +1,91 @@
+#include "rotationhandleitem.h"
+#include "handleeventrecorder.h"
+
+#include <QBrush>
+#include <QCursor>
+#include <QGraphicsSceneMouseEvent>
+#include <QLineF>
+
+GraphicsItemScaler::RotationHandleItem::RotationHandleItem(const QSizeF &size, qreal distance, GraphicsItemScaler *scaler)
+    : QGraphicsEllipseItem(QRectF(QPointF(-size.width() / 2, -distance - size.height()), size), scaler)
+    , mScaler(scaler)
+    , mHandleMoveAsRotation(false)
+{
+    setFlag(ItemIsSelectable);
+    setAcceptedMouseButtons(Qt::LeftButton);
+
+    setBrush(QBrush(Qt::black));
+    setCursor(Qt::CrossCursor);
+}
+
+void GraphicsItemScaler::RotationHandleItem::alignPosition(const QRectF &resizerRect)
+{
+    setPos(resizerRect.center().x(), resizerRect.top());
+
+    // Keep pointing away from the top side when the parent rotation is ignored
+    setRotation(flags() & ItemIgnoresTransformations ? scaler()->rotation() : 0);
+}
+
+void GraphicsItemScaler::RotationHandleItem::abortDrag()
+{
+    mHandleMoveAsRotation = false;
+}
+
+GraphicsItemScaler *GraphicsItemScaler::RotationHandleItem::scaler() const
+{
+    return mScaler;
+}
+
+void GraphicsItemScaler::RotationHandleItem::mousePressEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (auto recorder = scaler()->handleEventRecorder())
+        recorder->record(scaler(), HandleEvent::Press, Attachment, event);
+
+    // The scaler is already driven by a touch point or another handle
+    if (scaler()->mInteractiveScaling)
+    {
+        event->ignore();
+        return;
+    }
+
+    mHandleMoveAsRotation = true;
+    scaler()->beginInteractiveScaling();
+    event->accept();
+}
+
+void GraphicsItemScaler::RotationHandleItem::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (auto recorder = scaler()->handleEventRecorder())
+        recorder->record(scaler(), HandleEvent::Move, Attachment, event);
+
+    if (!mHandleMoveAsRotation)
+    {
+        event->ignore();
+        return;
+    }
+
+    auto center = scaler()->mapToScene(scaler()->handlesRect().center());
+
+    // QLineF angles are counter-clockwise, item rotation is clockwise
+    auto delta = QLineF(center, event->scenePos()).angle() - QLineF(center, event->lastScenePos()).angle();
+    if (delta > 180)
+        delta -= 360;
+    else if (delta < -180)
+        delta += 360;
+
+    scaler()->setRotationAroundCenter(scaler()->rotation() - delta);
+    scaler()->notifyScalingChanged();
+}
+
+void GraphicsItemScaler::RotationHandleItem::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
+{
+    if (auto recorder = scaler()->handleEventRecorder())
+        recorder->record(scaler(), HandleEvent::Release, Attachment, event);
+
+    event->setAccepted(mHandleMoveAsRotation);
+
+    if (mHandleMoveAsRotation)
+        scaler()->endInteractiveScaling();
+
+    mHandleMoveAsRotation = false;
+}
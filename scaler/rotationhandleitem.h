@@ -0,0 +1,32 @@
+#ifndef ROTATIONHANDLEITEM_H
+#define ROTATIONHANDLEITEM_H
+
+#include "graphicsitemscaler.h"
+#include <QGraphicsEllipseItem>
+
+class GraphicsItemScaler::RotationHandleItem : public QGraphicsEllipseItem
+{
+public:
+    // Identifies the rotation handle in recorded handle events
+    constexpr static int Attachment = 0x10;
+
+    explicit RotationHandleItem(const QSizeF &size, qreal distance, GraphicsItemScaler *scaler);
+
+    void alignPosition(const QRectF &resizerRect);
+    // Forgets a drag in progress without touching the scaler, later events of it are ignored
+    void abortDrag();
+
+    // QGraphicsItem interface
+protected:
+    virtual void mousePressEvent(QGraphicsSceneMouseEvent *event) override;
+    virtual void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;
+    virtual void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;
+
+private:
+    GraphicsItemScaler *scaler() const;
+
+    GraphicsItemScaler *mScaler;
+    bool mHandleMoveAsRotation;
+};
+
+#endif // ROTATIONHANDLEITEM_H
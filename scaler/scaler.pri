@@ -0,0 +1,33 @@
+# Sources of the scaler, shared by the example application and the tests
+
+QT += core gui concurrent network
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/graphicsitemscaler.cpp \
+    $$PWD/handleeventrecorder.cpp \
+    $$PWD/handleeventreplayer.cpp \
+    $$PWD/handleitem.cpp \
+    $$PWD/handlerstrategies.cpp \
+    $$PWD/pixmapscalingcache.cpp \
+    $$PWD/rotationhandleitem.cpp \
+    $$PWD/scalercommands.cpp \
+    $$PWD/scalermirror.cpp \
+    $$PWD/scalerselectionmanager.cpp \
+    $$PWD/scalerstate.cpp
+
+HEADERS += \
+    $$PWD/graphicsitemscaler.h \
+    $$PWD/handleeventrecorder.h \
+    $$PWD/handleeventreplayer.h \
+    $$PWD/handleitem.h \
+    $$PWD/handlerstrategies.h \
+    $$PWD/pixmapscalingcache.h \
+    $$PWD/rotationhandleitem.h \
+    $$PWD/scalercommands.h \
+    $$PWD/scalermirror.h \
+    $$PWD/scalerselectionmanager.h \
+    $$PWD/scalerstate.h
@@ -0,0 +1,171 @@
+#include "scalercommands.h"
+#include "graphicsitemscaler.h"
+
+// m11, m12, m21, m22, dx, dy of the target transform and of its scene transform,
+// then attached, x, y, rotation, transform origin x, y of the scaler
+static const int packedStateSize = 18;
+
+static void packTransform(const QTransform &t, qreal *state)
+{
+    state[0] = t.m11();
+    state[1] = t.m12();
+    state[2] = t.m21();
+    state[3] = t.m22();
+    state[4] = t.dx();
+    state[5] = t.dy();
+}
+
+static QTransform unpackTransform(const qreal *state)
+{
+    return QTransform(state[0], state[1], state[2], state[3], state[4], state[5]);
+}
+
+static ScalerState unpackState(const qreal *state)
+{
+    ScalerState s;
+    s.targetTransform = unpackTransform(state);
+    s.targetSceneTransform = unpackTransform(state + 6);
+    s.attached = state[12] != 0;
+    s.pos = QPointF(state[13], state[14]);
+    s.rotation = state[15];
+    s.transformOrigin = QPointF(state[16], state[17]);
+    return s;
+}
+
+QSet<ScalerCommand *> ScalerCommand::Commands;
+
+ScalerCommand::ScalerCommand(const QString &text, QUndoCommand *parent)
+    : QUndoCommand(text, parent)
+{
+    Commands.insert(this);
+}
+
+ScalerCommand::~ScalerCommand()
+{
+    Commands.remove(this);
+}
+
+void ScalerCommand::forgetTarget(QGraphicsItem *target)
+{
+    for (auto command : Commands)
+        command->removeTarget(target);
+}
+
+ScaleCommand::ScaleCommand(QGraphicsItem *target, const ScalerState &before, const ScalerState &after,
+                           QUndoCommand *parent)
+    : ScalerCommand(QObject::tr("Scale"), parent)
+    , mTarget(target)
+    , mBefore(before)
+    , mAfter(after)
+{
+
+}
+
+void ScaleCommand::undo()
+{
+    if (mTarget)
+        mBefore.applyTo(mTarget);
+}
+
+void ScaleCommand::redo()
+{
+    if (mTarget)
+        mAfter.applyTo(mTarget);
+}
+
+void ScaleCommand::removeTarget(QGraphicsItem *target)
+{
+    if (mTarget == target)
+        mTarget = nullptr;
+}
+
+BulkScaleCommand::BulkScaleCommand(const QList<QGraphicsItem *> &targets, const QString &text,
+                                   QUndoCommand *parent)
+    : ScalerCommand(text, parent)
+{
+    mTargets.reserve(targets.size());
+    for (auto target : targets)
+    {
+        if (target)
+            mTargets.append(target);
+    }
+
+    capture(&mBefore);
+}
+
+void BulkScaleCommand::undo()
+{
+    apply(mBefore);
+}
+
+void BulkScaleCommand::redo()
+{
+    // The operation has already been performed by the caller when the command is pushed
+    if (mAfter.isEmpty())
+        capture(&mAfter);
+    else
+        apply(mAfter);
+}
+
+int BulkScaleCommand::count() const
+{
+    return mTargets.size();
+}
+
+void BulkScaleCommand::removeTarget(QGraphicsItem *target)
+{
+    for (auto &t : mTargets)
+    {
+        if (t == target)
+            t = nullptr;
+    }
+}
+
+void BulkScaleCommand::capture(QVector<qreal> *states) const
+{
+    Q_ASSERT(states);
+
+    states->resize(mTargets.size() * packedStateSize);
+    qreal *state = states->data();
+
+    for (auto target : mTargets)
+    {
+        if (target)
+        {
+            auto s = ScalerState::capture(target);
+            packTransform(s.targetTransform, state);
+            packTransform(s.targetSceneTransform, state + 6);
+            state[12] = s.attached ? 1 : 0;
+            state[13] = s.pos.x();
+            state[14] = s.pos.y();
+            state[15] = s.rotation;
+            state[16] = s.transformOrigin.x();
+            state[17] = s.transformOrigin.y();
+        }
+        state += packedStateSize;
+    }
+}
+
+void BulkScaleCommand::apply(const QVector<qreal> &states) const
+{
+    Q_ASSERT(states.size() == mTargets.size() * packedStateSize);
+
+    // Most targets are attached to no scaler and are only given their transform and position
+    // in a single pass. The frames of the attached ones are fitted afterwards
+    QVector<int> attached;
+
+    for (int i = 0; i < mTargets.size(); ++i)
+    {
+        auto target = mTargets.at(i);
+        if (!target)
+            continue;
+
+        if (GraphicsItemScaler::scalerOf(target))
+            attached.append(i);
+        else
+            unpackState(states.constData() + i * packedStateSize).applyToDetached(target);
+    }
+
+    for (auto i : attached)
+        unpackState(states.constData() + i * packedStateSize).applyTo(mTargets.at(i));
+}
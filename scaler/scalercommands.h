@@ -0,0 +1,77 @@
+#ifndef SCALERCOMMANDS_H
+#define SCALERCOMMANDS_H
+
+#include <QSet>
+#include <QTransform>
+#include <QUndoCommand>
+#include <QVector>
+#include "scalerstate.h"
+
+// Base of the scale commands. Commands refer to targets rather than scalers, as scalers
+// may be retargeted or deleted by ScalerSelectionManager. Targets are not owned: a target
+// destroyed while attached to a scaler is left out of all commands, others have to
+// outlive the commands referring to them.
+class ScalerCommand : public QUndoCommand
+{
+public:
+    ~ScalerCommand();
+
+    static void forgetTarget(QGraphicsItem *target);
+
+protected:
+    explicit ScalerCommand(const QString &text, QUndoCommand *parent = nullptr);
+
+    virtual void removeTarget(QGraphicsItem *target) = 0;
+
+private:
+    static QSet<ScalerCommand *> Commands;
+};
+
+// A single interactive drag: only the state at press and at release is kept
+class ScaleCommand : public ScalerCommand
+{
+public:
+    explicit ScaleCommand(QGraphicsItem *target, const ScalerState &before, const ScalerState &after,
+                          QUndoCommand *parent = nullptr);
+
+    virtual void undo() override;
+    virtual void redo() override;
+
+protected:
+    virtual void removeTarget(QGraphicsItem *target) override;
+
+private:
+    QGraphicsItem *mTarget;
+    ScalerState mBefore;
+    ScalerState mAfter;
+};
+
+// Scaling of many items at once, attached to a scaler or not. Construct it before the
+// operation and push it to the stack afterwards: the first redo() records the resulting
+// state instead of applying it. States are kept in packed arrays, so the memory cost per
+// target is a fixed number of reals rather than a command object.
+// Only the affine part of the target transforms is stored.
+class BulkScaleCommand : public ScalerCommand
+{
+public:
+    explicit BulkScaleCommand(const QList<QGraphicsItem *> &targets, const QString &text,
+                              QUndoCommand *parent = nullptr);
+
+    virtual void undo() override;
+    virtual void redo() override;
+
+    int count() const;
+
+protected:
+    virtual void removeTarget(QGraphicsItem *target) override;
+
+private:
+    void capture(QVector<qreal> *states) const;
+    void apply(const QVector<qreal> &states) const;
+
+    QVector<QGraphicsItem *> mTargets;
+    QVector<qreal> mBefore;
+    QVector<qreal> mAfter;
+};
+
+#endif // SCALERCOMMANDS_H
@@ -0,0 +1,378 @@
+#include "scalermirror.h"
+#include "graphicsitemscaler.h"
+
+#include <QDataStream>
+#include <QGraphicsItem>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTimer>
+#include <limits>
+
+// A frame is: quint32 payload size, quint16 entry count and for every entry
+// quint32 id, quint8 mask of the changed values and the changed values as doubles
+static const int frameHeaderSize = sizeof(quint32);
+static const quint8 fullMask = (1 << ScalerMirrorState::Size) - 1;
+
+ScalerMirrorState ScalerMirrorState::fromTransform(const QTransform &transform)
+{
+    ScalerMirrorState state;
+    state.values[0] = transform.m11();
+    state.values[1] = transform.m12();
+    state.values[2] = transform.m21();
+    state.values[3] = transform.m22();
+    state.values[4] = transform.dx();
+    state.values[5] = transform.dy();
+    return state;
+}
+
+QTransform ScalerMirrorState::toTransform() const
+{
+    return QTransform(values[0], values[1], values[2], values[3], values[4], values[5]);
+}
+
+ScalerMirrorPublisher::ScalerMirrorPublisher(QObject *parent)
+    : QObject(parent)
+    , mServer(new QLocalServer(this))
+    , mFrameInterval(16)
+    , mFrameTimer(new QTimer(this))
+    , mBytesSent(0)
+    , mUpdatesSent(0)
+{
+    mFrameTimer->setSingleShot(true);
+    connect(mFrameTimer, &QTimer::timeout, this, &ScalerMirrorPublisher::flush);
+    connect(mServer, &QLocalServer::newConnection, this, &ScalerMirrorPublisher::onNewConnection);
+}
+
+ScalerMirrorPublisher::~ScalerMirrorPublisher()
+{
+    for (auto scaler : mScalers.values())
+        removeScaler(scaler);
+}
+
+bool ScalerMirrorPublisher::listen(const QString &name)
+{
+    QLocalServer::removeServer(name);
+    return mServer->listen(name);
+}
+
+void ScalerMirrorPublisher::close()
+{
+    mServer->close();
+
+    for (auto client : mClients)
+        client->disconnectFromServer();
+    mClients.clear();
+}
+
+void ScalerMirrorPublisher::addScaler(GraphicsItemScaler *scaler)
+{
+    Q_ASSERT(scaler);
+
+    if (mScalers.contains(scaler))
+        return;
+
+    mScalers.insert(scaler);
+    scaler->mMirrorPublishers.append(this);
+
+    auto changed = [this, scaler]() { markDirty(scaler); };
+    connect(scaler, &GraphicsItemScaler::xChanged, this, changed);
+    connect(scaler, &GraphicsItemScaler::yChanged, this, changed);
+    connect(scaler, &GraphicsItemScaler::rotationChanged, this, changed);
+    connect(scaler, &GraphicsItemScaler::scaleChanged, this, changed);
+    connect(scaler, &QObject::destroyed, this, [this, scaler]() { mScalers.remove(scaler); });
+
+    markDirty(scaler);
+}
+
+void ScalerMirrorPublisher::addScaler(GraphicsItemScaler *scaler, quint32 id)
+{
+    Q_ASSERT(scaler);
+
+    if (scaler->target())
+        addTarget(scaler->target(), id);
+
+    addScaler(scaler);
+}
+
+void ScalerMirrorPublisher::removeScaler(GraphicsItemScaler *scaler)
+{
+    if (!mScalers.remove(scaler))
+        return;
+
+    disconnect(scaler, nullptr, this, nullptr);
+
+    scaler->mMirrorPublishers.removeAll(this);
+}
+
+void ScalerMirrorPublisher::addTarget(QGraphicsItem *target, quint32 id)
+{
+    Q_ASSERT(target);
+
+    mEntries.insert(target, Entry { id, false, ScalerMirrorState() });
+
+    if (auto scaler = GraphicsItemScaler::scalerOf(target))
+    {
+        if (mScalers.contains(scaler))
+            markDirty(scaler);
+    }
+}
+
+void ScalerMirrorPublisher::removeTarget(QGraphicsItem *target)
+{
+    mEntries.remove(target);
+    mDirty.remove(target);
+}
+
+int ScalerMirrorPublisher::frameInterval() const
+{
+    return mFrameInterval;
+}
+
+void ScalerMirrorPublisher::setFrameInterval(int msec)
+{
+    mFrameInterval = qMax(0, msec);
+}
+
+quint64 ScalerMirrorPublisher::bytesSent() const
+{
+    return mBytesSent;
+}
+
+quint64 ScalerMirrorPublisher::updatesSent() const
+{
+    return mUpdatesSent;
+}
+
+void ScalerMirrorPublisher::onNewConnection()
+{
+    while (auto client = mServer->nextPendingConnection())
+    {
+        mClients.append(client);
+        connect(client, &QLocalSocket::disconnected, this, [this, client]() {
+            mClients.removeOne(client);
+            client->deleteLater();
+        });
+
+        // Snapshot of everything published so far, the next frames are deltas to it. The
+        // count field limits a frame, so a large snapshot is split as flush() does
+        auto entry = mEntries.constBegin();
+        while (entry != mEntries.constEnd())
+        {
+            QByteArray frame;
+            QDataStream stream(&frame, QIODevice::WriteOnly);
+            stream << quint32(0) << quint16(0);
+
+            quint16 count = 0;
+            for (; entry != mEntries.constEnd() && count < std::numeric_limits<quint16>::max(); ++entry)
+            {
+                if (!entry->published)
+                    continue;
+
+                stream << entry->id << fullMask;
+                for (auto value : entry->state.values)
+                    stream << value;
+                ++count;
+            }
+
+            if (count == 0)
+                break;
+
+            stream.device()->seek(0);
+            stream << quint32(frame.size() - frameHeaderSize) << count;
+            send(frame, client);
+        }
+    }
+}
+
+void ScalerMirrorPublisher::flush()
+{
+    mFrameTimer->stop();
+    mLastFrame.start();
+
+    QByteArray frame;
+    QDataStream stream(&frame, QIODevice::WriteOnly);
+    stream << quint32(0) << quint16(0);
+
+    // The count field limits a frame, the rest is left for the next one
+    quint16 count = 0;
+    for (auto dirty = mDirty.begin(); dirty != mDirty.end() && count < std::numeric_limits<quint16>::max();
+         dirty = mDirty.erase(dirty))
+    {
+        auto it = mEntries.find(dirty.key());
+        if (it == mEntries.end())
+            continue;
+
+        const auto &state = dirty.value();
+
+        quint8 mask = 0;
+        for (int i = 0; i < ScalerMirrorState::Size; ++i)
+        {
+            if (!it->published || state.values[i] != it->state.values[i])
+                mask |= 1 << i;
+        }
+
+        if (mask == 0)
+            continue;
+
+        stream << it->id << mask;
+        for (int i = 0; i < ScalerMirrorState::Size; ++i)
+        {
+            if (mask & (1 << i))
+                stream << state.values[i];
+        }
+
+        it->published = true;
+        it->state = state;
+        ++count;
+    }
+
+    if (!mDirty.isEmpty())
+        mFrameTimer->start(mFrameInterval);
+
+    if (count == 0)
+        return;
+
+    stream.device()->seek(0);
+    stream << quint32(frame.size() - frameHeaderSize) << count;
+
+    mUpdatesSent += count;
+    send(frame);
+}
+
+void ScalerMirrorPublisher::markDirty(GraphicsItemScaler *scaler)
+{
+    auto target = scaler->target();
+    if (!target || !mEntries.contains(target))
+        return;
+
+    mDirty.insert(target, ScalerMirrorState::fromTransform(target->sceneTransform()));
+
+    if (mFrameTimer->isActive())
+        return;
+
+    qint64 remaining = mLastFrame.isValid() ? mFrameInterval - mLastFrame.elapsed() : 0;
+    mFrameTimer->start(int(qMax<qint64>(0, remaining)));
+}
+
+void ScalerMirrorPublisher::send(const QByteArray &frame, QLocalSocket *client)
+{
+    if (client)
+    {
+        client->write(frame);
+        mBytesSent += quint64(frame.size());
+        return;
+    }
+
+    for (auto c : mClients)
+    {
+        c->write(frame);
+        mBytesSent += quint64(frame.size());
+    }
+}
+
+ScalerMirrorSubscriber::ScalerMirrorSubscriber(QObject *parent)
+    : QObject(parent)
+    , mSocket(new QLocalSocket(this))
+    , mBytesReceived(0)
+    , mUpdatesApplied(0)
+{
+    connect(mSocket, &QLocalSocket::readyRead, this, &ScalerMirrorSubscriber::onReadyRead);
+    connect(mSocket, &QLocalSocket::disconnected, this, &ScalerMirrorSubscriber::disconnected);
+}
+
+void ScalerMirrorSubscriber::connectToPublisher(const QString &name)
+{
+    mBuffer.clear();
+    mSocket->connectToServer(name, QIODevice::ReadOnly);
+}
+
+void ScalerMirrorSubscriber::disconnectFromPublisher()
+{
+    mSocket->disconnectFromServer();
+}
+
+void ScalerMirrorSubscriber::addItem(quint32 id, QGraphicsItem *item)
+{
+    Q_ASSERT(item);
+
+    mItems.insert(id, item);
+
+    auto it = mStates.constFind(id);
+    if (it != mStates.constEnd())
+        item->setTransform(it->toTransform());
+}
+
+void ScalerMirrorSubscriber::removeItem(quint32 id)
+{
+    mItems.remove(id);
+}
+
+quint64 ScalerMirrorSubscriber::bytesReceived() const
+{
+    return mBytesReceived;
+}
+
+quint64 ScalerMirrorSubscriber::updatesApplied() const
+{
+    return mUpdatesApplied;
+}
+
+void ScalerMirrorSubscriber::onReadyRead()
+{
+    auto data = mSocket->readAll();
+    mBytesReceived += quint64(data.size());
+    mBuffer.append(data);
+
+    // Decode every complete frame first and apply only the final state of every item
+    QSet<quint32> changed;
+    int offset = 0;
+
+    while (mBuffer.size() - offset >= frameHeaderSize)
+    {
+        QDataStream header(mBuffer.mid(offset, frameHeaderSize));
+        quint32 size = 0;
+        header >> size;
+
+        if (quint32(mBuffer.size() - offset - frameHeaderSize) < size)
+            break;
+
+        QDataStream stream(mBuffer.mid(offset + frameHeaderSize, int(size)));
+        offset += frameHeaderSize + int(size);
+
+        quint16 count = 0;
+        stream >> count;
+
+        for (quint16 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+        {
+            quint32 id = 0;
+            quint8 mask = 0;
+            stream >> id >> mask;
+
+            auto &state = mStates[id];
+            for (int j = 0; j < ScalerMirrorState::Size; ++j)
+            {
+                if (mask & (1 << j))
+                    stream >> state.values[j];
+            }
+
+            changed.insert(id);
+        }
+    }
+
+    mBuffer.remove(0, offset);
+
+    if (changed.isEmpty())
+        return;
+
+    for (auto id : changed)
+    {
+        auto item = mItems.value(id);
+        if (!item)
+            continue;
+
+        item->setTransform(mStates.value(id).toTransform());
+        ++mUpdatesApplied;
+    }
+
+    emit updated();
+}
@@ -0,0 +1,132 @@
+#ifndef SCALERMIRROR_H
+#define SCALERMIRROR_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QTransform>
+
+class QGraphicsItem;
+class QLocalServer;
+class QLocalSocket;
+class QTimer;
+class GraphicsItemScaler;
+
+// Affine part of the scene transform of a target: m11, m12, m21, m22, dx, dy
+struct ScalerMirrorState
+{
+    enum { Size = 6 };
+
+    qreal values[Size] = { 1, 0, 0, 1, 0, 0 };
+
+    static ScalerMirrorState fromTransform(const QTransform &transform);
+    QTransform toTransform() const;
+};
+
+// Streams the scene transforms of the targets of several scalers to other processes.
+// Ids belong to the targets, so a scaler retargeted by ScalerSelectionManager keeps the
+// old target under its id and publishes the new one only if it has an id as well.
+// Changes are coalesced to one frame per interval and only the changed values of every
+// transform are sent. A client connecting later gets a full snapshot first.
+class ScalerMirrorPublisher : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ScalerMirrorPublisher(QObject *parent = nullptr);
+    ~ScalerMirrorPublisher();
+
+    bool listen(const QString &name);
+    void close();
+
+    // Publishes the changes of every target of the scaler which has an id
+    void addScaler(GraphicsItemScaler *scaler);
+    // Also gives the current target of the scaler the id
+    void addScaler(GraphicsItemScaler *scaler, quint32 id);
+    void removeScaler(GraphicsItemScaler *scaler);
+
+    // The id identifies the mirrored item on the subscriber side. Targets are not owned,
+    // one destroyed while attached to a scaler is removed automatically
+    void addTarget(QGraphicsItem *target, quint32 id);
+    void removeTarget(QGraphicsItem *target);
+
+    int frameInterval() const;
+    // Minimum time between two frames, in milliseconds
+    void setFrameInterval(int msec);
+
+    quint64 bytesSent() const;
+    quint64 updatesSent() const;
+
+private slots:
+    void onNewConnection();
+    void flush();
+
+private:
+    friend class GraphicsItemScaler;
+
+    struct Entry
+    {
+        quint32 id;
+        bool published;
+        ScalerMirrorState state;
+    };
+
+    void markDirty(GraphicsItemScaler *scaler);
+    void send(const QByteArray &frame, QLocalSocket *client = nullptr);
+
+    QLocalServer *mServer;
+    QList<QLocalSocket *> mClients;
+
+    QSet<GraphicsItemScaler *> mScalers;
+    QHash<QGraphicsItem *, Entry> mEntries;
+    // Taken when the change is reported, the target may be gone by the next frame
+    QHash<QGraphicsItem *, ScalerMirrorState> mDirty;
+
+    int mFrameInterval;
+    QTimer *mFrameTimer;
+    QElapsedTimer mLastFrame;
+
+    quint64 mBytesSent;
+    quint64 mUpdatesSent;
+};
+
+// Applies the updates of a ScalerMirrorPublisher to items of another scene. All updates
+// received at once are collapsed and every item is updated only once. Mirror items are
+// placed purely by their transform: it is set to the scene transform of the published
+// target, so they should be top level items at the origin without rotation or scale.
+class ScalerMirrorSubscriber : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ScalerMirrorSubscriber(QObject *parent = nullptr);
+
+    void connectToPublisher(const QString &name);
+    void disconnectFromPublisher();
+
+    // Items are not owned and have to be removed before they are destroyed
+    void addItem(quint32 id, QGraphicsItem *item);
+    void removeItem(quint32 id);
+
+    quint64 bytesReceived() const;
+    quint64 updatesApplied() const;
+
+signals:
+    void updated();
+    // The publisher closed the connection or went away
+    void disconnected();
+
+private slots:
+    void onReadyRead();
+
+private:
+    QLocalSocket *mSocket;
+    QByteArray mBuffer;
+
+    QHash<quint32, QGraphicsItem *> mItems;
+    QHash<quint32, ScalerMirrorState> mStates;
+
+    quint64 mBytesReceived;
+    quint64 mUpdatesApplied;
+};
+
+#endif // SCALERMIRROR_H
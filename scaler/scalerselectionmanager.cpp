@@ -0,0 +1,146 @@
+#include "scalerselectionmanager.h"
+#include "graphicsitemscaler.h"
+
+#include <QGraphicsScene>
+#include <QSet>
+
+ScalerSelectionManager::ScalerSelectionManager(QGraphicsScene *scene, QObject *parent)
+    : QObject(parent)
+    , mScene(scene)
+    , mMaximumScalers(100)
+    , mUpdating(false)
+{
+    Q_ASSERT(mScene);
+
+    connect(scene, &QGraphicsScene::selectionChanged, this, &ScalerSelectionManager::updateScalers);
+    updateScalers();
+}
+
+ScalerSelectionManager::~ScalerSelectionManager()
+{
+    mUpdating = true;
+
+    // The scene has already deleted the scalers together with their targets
+    if (!mScene)
+        return;
+
+    // Scalers are deleted as children, the targets have to survive them
+    for (const auto &scaler : mScalers)
+    {
+        if (scaler)
+            scaler->setTarget(nullptr);
+    }
+}
+
+int ScalerSelectionManager::maximumScalers() const
+{
+    return mMaximumScalers;
+}
+
+void ScalerSelectionManager::setMaximumScalers(int count)
+{
+    mMaximumScalers = qMax(0, count);
+
+    while (!mPool.isEmpty() && mScalers.size() + mPool.size() > mMaximumScalers)
+        delete mPool.takeLast().data();
+
+    updateScalers();
+}
+
+QList<GraphicsItemScaler *> ScalerSelectionManager::scalers() const
+{
+    QList<GraphicsItemScaler *> scalers;
+    for (const auto &scaler : mScalers)
+    {
+        if (scaler)
+            scalers.append(scaler);
+    }
+    return scalers;
+}
+
+void ScalerSelectionManager::updateScalers()
+{
+    // Releasing a scaler deselects its handles, which emits selectionChanged again
+    if (!mScene || mUpdating)
+        return;
+
+    mUpdating = true;
+
+    QSet<QGraphicsItem *> targets;
+    for (auto item : mScene->selectedItems())
+    {
+        if (auto target = targetOf(item))
+            targets.insert(target);
+    }
+
+    // Release first, so the scalers can be reused right away. A scaler whose target was
+    // destroyed has dropped it already, the key may even be reused by a new item
+    for (auto it = mScalers.begin(); it != mScalers.end();)
+    {
+        if (!targets.contains(it.key()) || !it.value() || it.value()->target() != it.key())
+        {
+            release(it.value());
+            it = mScalers.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    for (auto target : targets)
+    {
+        if (mScalers.size() >= mMaximumScalers)
+            break;
+
+        if (!mScalers.contains(target))
+            mScalers.insert(target, acquire(target));
+    }
+
+    mUpdating = false;
+}
+
+QGraphicsItem *ScalerSelectionManager::targetOf(QGraphicsItem *item) const
+{
+    if (auto scaler = qobject_cast<GraphicsItemScaler *>(item->toGraphicsObject()))
+        return scaler->parent() == this ? scaler->target() : nullptr;
+
+    // Handles and targets of scalers stand for the target, other scalers are left alone
+    auto parent = item->parentItem();
+    if (auto scaler = qobject_cast<GraphicsItemScaler *>(parent ? parent->toGraphicsObject() : nullptr))
+        return scaler->parent() == this ? scaler->target() : nullptr;
+
+    return item;
+}
+
+GraphicsItemScaler *ScalerSelectionManager::acquire(QGraphicsItem *target)
+{
+    while (!mPool.isEmpty())
+    {
+        if (auto scaler = mPool.takeLast())
+        {
+            scaler->setTarget(target);
+            return scaler;
+        }
+    }
+
+    auto scaler = new GraphicsItemScaler(nullptr);
+    scaler->setParent(this);
+    mScene->addItem(scaler);
+    emit scalerCreated(scaler);
+
+    scaler->setTarget(target);
+    return scaler;
+}
+
+void ScalerSelectionManager::release(GraphicsItemScaler *scaler)
+{
+    if (!scaler)
+        return;
+
+    scaler->setTarget(nullptr);
+
+    // Deferred, the scaler may be the one being destroyed
+    if (mScalers.size() + mPool.size() > mMaximumScalers)
+        scaler->deleteLater();
+    else
+        mPool.append(scaler);
+}
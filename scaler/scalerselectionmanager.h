@@ -0,0 +1,49 @@
+#ifndef SCALERSELECTIONMANAGER_H
+#define SCALERSELECTIONMANAGER_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QVector>
+
+class QGraphicsItem;
+class QGraphicsScene;
+class GraphicsItemScaler;
+
+// Attaches scalers to the selected items of a scene. Scalers of deselected items are
+// retargeted to newly selected ones instead of being destroyed and created again.
+class ScalerSelectionManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ScalerSelectionManager(QGraphicsScene *scene, QObject *parent = nullptr);
+    ~ScalerSelectionManager();
+
+    int maximumScalers() const;
+    // Limits the number of scalers, both attached and pooled. Selected items beyond
+    // the limit get no scaler
+    void setMaximumScalers(int count);
+
+    QList<GraphicsItemScaler *> scalers() const;
+
+signals:
+    // Emitted for every new scaler, e.g. to set its pens and brushes
+    void scalerCreated(GraphicsItemScaler *scaler);
+
+public slots:
+    void updateScalers();
+
+private:
+    QGraphicsItem *targetOf(QGraphicsItem *item) const;
+    GraphicsItemScaler *acquire(QGraphicsItem *target);
+    void release(GraphicsItemScaler *scaler);
+
+    QPointer<QGraphicsScene> mScene;
+    // Scalers are deleted with the scene if it goes first
+    QHash<QGraphicsItem *, QPointer<GraphicsItemScaler>> mScalers;
+    QVector<QPointer<GraphicsItemScaler>> mPool;
+    int mMaximumScalers;
+    bool mUpdating;
+};
+
+#endif // SCALERSELECTIONMANAGER_H
@@ -0,0 +1,78 @@
+#include "scalerstate.h"
+#include "graphicsitemscaler.h"
+
+ScalerState ScalerState::capture(const QGraphicsItem *target)
+{
+    Q_ASSERT(target);
+
+    ScalerState state;
+    state.targetTransform = target->transform();
+    state.targetSceneTransform = target->sceneTransform();
+
+    if (auto scaler = GraphicsItemScaler::scalerOf(target))
+    {
+        state.attached = true;
+        state.pos = scaler->pos();
+        state.rotation = scaler->rotation();
+        state.transformOrigin = scaler->transformOriginPoint();
+    }
+    return state;
+}
+
+void ScalerState::applyTo(QGraphicsItem *target) const
+{
+    Q_ASSERT(target);
+
+    auto scaler = GraphicsItemScaler::scalerOf(target);
+    if (!scaler)
+    {
+        applyToDetached(target);
+        return;
+    }
+
+    target->setTransform(targetTransform);
+    scaler->recalculate();
+
+    if (attached)
+    {
+        scaler->setTransformOriginPoint(transformOrigin);
+        scaler->setRotation(rotation);
+        scaler->setPos(pos);
+        return;
+    }
+
+    // Captured without a scaler, the scaler is placed as by setTarget()
+    scaler->setTransformOriginPoint(QPointF());
+    scaler->setRotation(0);
+
+    auto parent = scaler->parentItem();
+    auto scenePos = targetSceneTransform.map(QPointF());
+    auto offset = parent ? parent->mapFromScene(scenePos) - parent->mapFromScene(target->scenePos())
+                         : scenePos - target->scenePos();
+    scaler->setPos(scaler->pos() + offset);
+
+    // A rotation kept in the target transform on release goes back to the scaler
+    scaler->adoptTargetRotation();
+}
+
+void ScalerState::applyToDetached(QGraphicsItem *target) const
+{
+    Q_ASSERT(target);
+
+    target->setTransform(targetTransform);
+
+    auto parent = target->parentItem();
+    auto scenePos = targetSceneTransform.map(QPointF());
+    target->setPos(parent ? parent->mapFromScene(scenePos) : scenePos);
+
+    // The scaler rotation is kept in the target transform on release
+    if (attached && !qFuzzyIsNull(rotation))
+        target->setTransform(targetSceneTransform * target->sceneTransform().inverted() * target->transform());
+}
+
+bool ScalerState::operator==(const ScalerState &other) const
+{
+    return targetTransform == other.targetTransform && targetSceneTransform == other.targetSceneTransform
+        && attached == other.attached && pos == other.pos
+        && rotation == other.rotation && transformOrigin == other.transformOrigin;
+}
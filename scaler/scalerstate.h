@@ -0,0 +1,33 @@
+#ifndef SCALERSTATE_H
+#define SCALERSTATE_H
+
+#include <QPointF>
+#include <QTransform>
+
+class QGraphicsItem;
+
+// Everything needed to restore the geometry of a target and of the scaler it is attached
+// to. States belong to the target: ScalerSelectionManager may retarget or delete a scaler
+// in the meantime, so a state is applied to whichever scaler holds the target then.
+struct ScalerState
+{
+    QTransform targetTransform;
+    // Used to place the target when it is attached to no scaler
+    QTransform targetSceneTransform;
+
+    // Geometry of the scaler, only valid if the target was attached
+    bool attached = false;
+    QPointF pos;
+    qreal rotation = 0;
+    QPointF transformOrigin;
+
+    static ScalerState capture(const QGraphicsItem *target);
+    void applyTo(QGraphicsItem *target) const;
+    // Part of applyTo() for a target attached to no scaler, nothing is fitted or mapped
+    void applyToDetached(QGraphicsItem *target) const;
+
+    bool operator==(const ScalerState &other) const;
+    bool operator!=(const ScalerState &other) const { return !(*this == other); }
+};
+
+#endif // SCALERSTATE_H
@@ -0,0 +1,10 @@
+QT += testlib
+
+CONFIG += testcase
+
+TARGET = tst_frameupdates
+TEMPLATE = app
+
+include(../../scaler/scaler.pri)
+
+SOURCES += tst_frameupdates.cpp
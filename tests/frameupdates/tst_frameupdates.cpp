@@ -0,0 +1,177 @@
+#include <QtTest>
+#include <QGraphicsRectItem>
+#include <QGraphicsScene>
+#include <QGraphicsSceneMouseEvent>
+#include <QGraphicsView>
+#include <QPaintEvent>
+#include "graphicsitemscaler.h"
+
+// Attachment flags of the handles, as taken by GraphicsItemScaler::handleItem()
+static const int leftHandle = 0x1;
+static const int rightHandle = 0x8;
+
+static const int dragSteps = 100;
+static const qreal stepLength = 2;
+
+// Collects the region painted on a viewport
+class PaintCounter : public QObject
+{
+public:
+    QRegion painted;
+
+protected:
+    virtual bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if (event->type() == QEvent::Paint)
+            painted += static_cast<QPaintEvent *>(event)->region();
+        return QObject::eventFilter(watched, event);
+    }
+};
+
+struct DragResult
+{
+    // Sum of the areas painted after each step, in pixels
+    qint64 exposedArea = 0;
+    QRectF targetRect;
+    bool scalerMoved = false;
+};
+
+static qint64 area(const QRegion &region)
+{
+    qint64 result = 0;
+    for (const QRect &rect : region)
+        result += qint64(rect.width()) * rect.height();
+    return result;
+}
+
+static bool fuzzyEqual(const QRectF &a, const QRectF &b)
+{
+    return qAbs(a.left() - b.left()) < 1e-6 && qAbs(a.top() - b.top()) < 1e-6
+        && qAbs(a.right() - b.right()) < 1e-6 && qAbs(a.bottom() - b.bottom()) < 1e-6;
+}
+
+static void sendMouseEvent(QGraphicsItem *handle, QEvent::Type type, const QPointF &scenePos, const QPointF &lastScenePos)
+{
+    QGraphicsSceneMouseEvent event(type);
+    event.setPos(handle->mapFromScene(scenePos));
+    event.setScenePos(scenePos);
+    event.setLastScenePos(lastScenePos);
+    event.setButton(type == QEvent::GraphicsSceneMouseMove ? Qt::NoButton : Qt::LeftButton);
+    event.setButtons(type == QEvent::GraphicsSceneMouseRelease ? Qt::NoButton : Qt::LeftButton);
+    handle->scene()->sendEvent(handle, &event);
+}
+
+// Drags a side handle of a scaler shown 1:1 in a view and measures how much of the
+// viewport is repainted for every step. The target paints nothing itself, like a group
+// of items placed elsewhere, and lies over a heavy background item: on the screen only
+// the frame and the handles change
+class tst_FrameUpdates : public QObject
+{
+    Q_OBJECT
+private slots:
+    void exposedArea_data();
+    void exposedArea();
+
+private:
+    void drag(int attachment, bool partial, DragResult *result);
+};
+
+void tst_FrameUpdates::drag(int attachment, bool partial, DragResult *result)
+{
+    QGraphicsScene scene(0, 0, 1000, 800);
+
+    auto background = scene.addRect(scene.sceneRect(), Qt::NoPen, QBrush(Qt::darkGray, Qt::Dense5Pattern));
+    background->setZValue(-1);
+
+    auto target = new QGraphicsRectItem(0, 0, 400, 300);
+    target->setFlag(QGraphicsItem::ItemHasNoContents);
+
+    auto scaler = new GraphicsItemScaler(target);
+    scaler->setBoundingRectAreaVisible(true);
+    // An opaque interior changes with the frame, so it turns partial updates off
+    if (!partial)
+        scaler->setBoundingRectAreaBrush(Qt::white);
+    scaler->setPos(300, 250);
+    scene.addItem(scaler);
+
+    QGraphicsView view(&scene);
+    view.setFrameShape(QFrame::NoFrame);
+    view.setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    view.setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    view.setAlignment(Qt::AlignLeft | Qt::AlignTop);
+    view.setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+    view.resize(1000, 800);
+    view.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&view));
+
+    PaintCounter counter;
+    view.viewport()->installEventFilter(&counter);
+    QTest::qWait(50);
+
+    auto handle = scaler->handleItem(attachment);
+    QVERIFY(handle);
+
+    auto direction = attachment == leftHandle ? -1 : 1;
+    auto scenePos = handle->sceneBoundingRect().center();
+    auto scalerPos = scaler->pos();
+
+    sendMouseEvent(handle, QEvent::GraphicsSceneMousePress, scenePos, scenePos);
+
+    for (int i = 0; i < dragSteps; ++i)
+    {
+        auto lastScenePos = scenePos;
+        scenePos += QPointF(direction * stepLength, 0);
+
+        counter.painted = QRegion();
+        sendMouseEvent(handle, QEvent::GraphicsSceneMouseMove, scenePos, lastScenePos);
+        QTest::qWait(5);
+
+        result->exposedArea += area(counter.painted);
+        result->scalerMoved |= scaler->pos() != scalerPos;
+    }
+
+    sendMouseEvent(handle, QEvent::GraphicsSceneMouseRelease, scenePos, scenePos);
+
+    // The frame starts at the origin again once the drag is finished
+    QCOMPARE(scaler->handlesRect().topLeft(), QPointF());
+    result->targetRect = target->sceneBoundingRect();
+}
+
+void tst_FrameUpdates::exposedArea_data()
+{
+    QTest::addColumn<int>("attachment");
+
+    QTest::newRow("right") << rightHandle;
+    QTest::newRow("left") << leftHandle;
+}
+
+void tst_FrameUpdates::exposedArea()
+{
+    QFETCH(int, attachment);
+
+    DragResult partial;
+    drag(attachment, true, &partial);
+    if (QTest::currentTestFailed())
+        return;
+
+    DragResult full;
+    drag(attachment, false, &full);
+    if (QTest::currentTestFailed())
+        return;
+
+    qInfo("%lld px per step repainted with partial updates, %lld px without",
+          partial.exposedArea / dragSteps, full.exposedArea / dragSteps);
+
+    // Both ways end with the same geometry, but the scaler itself stays in place
+    QVERIFY(fuzzyEqual(partial.targetRect, full.targetRect));
+    QVERIFY(!partial.scalerMoved);
+
+    // Regrowing the reserve repaints all of it a few times per drag, the strips save the rest
+    QVERIFY2(partial.exposedArea * 3 < full.exposedArea,
+             qPrintable(QString("%1 px repainted with partial updates, %2 px without")
+                        .arg(partial.exposedArea).arg(full.exposedArea)));
+}
+
+QTEST_MAIN(tst_FrameUpdates)
+
+#include "tst_frameupdates.moc"
@@ -0,0 +1,10 @@
+QT += testlib
+
+CONFIG += testcase
+
+TARGET = tst_mirror
+TEMPLATE = app
+
+include(../../scaler/scaler.pri)
+
+SOURCES += tst_mirror.cpp
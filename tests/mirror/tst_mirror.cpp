@@ -0,0 +1,248 @@
+#include <QtTest>
+#include <QApplication>
+#include <QGraphicsRectItem>
+#include <QGraphicsScene>
+#include <QGraphicsSceneMouseEvent>
+#include <QProcess>
+#include "graphicsitemscaler.h"
+#include "scalermirror.h"
+
+// Attachment flag of the right handle, as taken by GraphicsItemScaler::handleItem()
+static const int rightHandle = 0x8;
+
+static const int scalerCount = 4;
+static const int dragCount = 10;
+static const int dragSteps = 50;
+
+static void sendMouseEvent(QGraphicsItem *handle, QEvent::Type type, const QPointF &scenePos, const QPointF &lastScenePos)
+{
+    QGraphicsSceneMouseEvent event(type);
+    event.setPos(handle->mapFromScene(scenePos));
+    event.setScenePos(scenePos);
+    event.setLastScenePos(lastScenePos);
+    event.setButton(type == QEvent::GraphicsSceneMouseMove ? Qt::NoButton : Qt::LeftButton);
+    event.setButtons(type == QEvent::GraphicsSceneMouseRelease ? Qt::NoButton : Qt::LeftButton);
+    handle->scene()->sendEvent(handle, &event);
+}
+
+// Started by the test as a separate process. Mirrors the published targets until the
+// publisher disconnects, then prints the update and byte counts and the final transforms
+static int runSubscriber(const QString &name, int count)
+{
+    QVector<QGraphicsRectItem *> items;
+    ScalerMirrorSubscriber subscriber;
+    for (int i = 0; i < count; ++i)
+    {
+        items.append(new QGraphicsRectItem(0, 0, 100, 100));
+        subscriber.addItem(quint32(i), items.last());
+    }
+
+    QObject::connect(&subscriber, &ScalerMirrorSubscriber::disconnected, qApp, &QCoreApplication::quit);
+    subscriber.connectToPublisher(name);
+    QCoreApplication::exec();
+
+    QTextStream out(stdout);
+    out.setRealNumberPrecision(17);
+    out << subscriber.updatesApplied() << ' ' << subscriber.bytesReceived() << '\n';
+    for (auto item : items)
+    {
+        auto t = item->transform();
+        out << t.m11() << ' ' << t.m12() << ' ' << t.m21() << ' ' << t.m22() << ' ' << t.dx() << ' ' << t.dy() << '\n';
+    }
+
+    qDeleteAll(items);
+    return 0;
+}
+
+static void startSubscriber(QProcess *subscriber, const QString &name, int count)
+{
+    auto environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("QT_QPA_PLATFORM", "offscreen");
+    subscriber->setProcessEnvironment(environment);
+    subscriber->start(QCoreApplication::applicationFilePath(), { "--subscriber", name, QString::number(count) });
+}
+
+// Compares a transform printed by the subscriber with the expected one
+static bool readTransform(QTextStream *in, const QTransform &expected)
+{
+    qreal m11, m12, m21, m22, dx, dy;
+    *in >> m11 >> m12 >> m21 >> m22 >> dx >> dy;
+
+    return in->status() == QTextStream::Ok
+        && qFuzzyCompare(m11, expected.m11()) && qFuzzyCompare(m12 + 1, expected.m12() + 1)
+        && qFuzzyCompare(m21 + 1, expected.m21() + 1) && qFuzzyCompare(m22, expected.m22())
+        && qFuzzyCompare(dx + 1, expected.dx() + 1) && qFuzzyCompare(dy + 1, expected.dy() + 1);
+}
+
+// Drags handles of published scalers while a subscriber runs in another process and
+// measures the updates per second and the bytes sent per drag
+class tst_Mirror : public QObject
+{
+    Q_OBJECT
+private slots:
+    void twoProcesses_data();
+    void twoProcesses();
+    void largeSnapshot();
+};
+
+void tst_Mirror::twoProcesses_data()
+{
+    QTest::addColumn<int>("frameInterval");
+
+    QTest::newRow("16 ms frames") << 16;
+    QTest::newRow("no coalescing") << 0;
+}
+
+void tst_Mirror::twoProcesses()
+{
+    QFETCH(int, frameInterval);
+
+    QGraphicsScene scene;
+    QList<GraphicsItemScaler *> scalers;
+    for (int i = 0; i < scalerCount; ++i)
+    {
+        auto scaler = new GraphicsItemScaler(new QGraphicsRectItem(0, 0, 100, 100));
+        scaler->setPos(i * 300, 0);
+        scene.addItem(scaler);
+        scalers.append(scaler);
+    }
+
+    auto name = QString("tst_mirror_%1").arg(QCoreApplication::applicationPid());
+    ScalerMirrorPublisher publisher;
+    publisher.setFrameInterval(frameInterval);
+    QVERIFY(publisher.listen(name));
+    for (int i = 0; i < scalerCount; ++i)
+        publisher.addScaler(scalers.at(i), quint32(i));
+
+    QProcess subscriber;
+    startSubscriber(&subscriber, name, scalerCount);
+    QVERIFY(subscriber.waitForStarted());
+
+    // The snapshot is sent as soon as the subscriber connects
+    QTRY_VERIFY_WITH_TIMEOUT(publisher.bytesSent() > 0, 10000);
+
+    auto bytesBefore = publisher.bytesSent();
+    auto updatesBefore = publisher.updatesSent();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int drag = 0; drag < dragCount; ++drag)
+    {
+        auto handle = scalers.at(drag % scalerCount)->handleItem(rightHandle);
+        QVERIFY(handle);
+
+        // Out and back, so the targets keep a reasonable size
+        auto direction = drag / scalerCount % 2 ? -1 : 1;
+        auto scenePos = handle->sceneBoundingRect().center();
+        sendMouseEvent(handle, QEvent::GraphicsSceneMousePress, scenePos, scenePos);
+
+        for (int i = 0; i < dragSteps; ++i)
+        {
+            auto lastScenePos = scenePos;
+            scenePos += QPointF(direction, 0);
+            sendMouseEvent(handle, QEvent::GraphicsSceneMouseMove, scenePos, lastScenePos);
+            QTest::qWait(2);
+        }
+
+        sendMouseEvent(handle, QEvent::GraphicsSceneMouseRelease, scenePos, scenePos);
+    }
+
+    // Let the last frame go out
+    QTest::qWait(frameInterval + 20);
+    auto elapsed = timer.elapsed();
+
+    auto updates = publisher.updatesSent() - updatesBefore;
+    auto bytes = publisher.bytesSent() - bytesBefore;
+
+    // Keep the event loop running, the subscriber quits once the disconnect reaches it
+    publisher.close();
+    QTRY_COMPARE_WITH_TIMEOUT(subscriber.state(), QProcess::NotRunning, 10000);
+    QCOMPARE(subscriber.exitStatus(), QProcess::NormalExit);
+    QCOMPARE(subscriber.exitCode(), 0);
+
+    auto output = subscriber.readAllStandardOutput();
+    QTextStream in(&output);
+
+    quint64 updatesApplied = 0, bytesReceived = 0;
+    in >> updatesApplied >> bytesReceived;
+    QCOMPARE(bytesReceived, publisher.bytesSent());
+
+    // The mirrors end where the targets are
+    for (auto scaler : scalers)
+        QVERIFY(readTransform(&in, scaler->target()->sceneTransform()));
+
+    qInfo("%.0f updates/s sent, %llu applied, %llu bytes per drag",
+          updates * 1000.0 / qMax<qint64>(1, elapsed), updatesApplied, bytes / dragCount);
+
+    // Testlib has no unit for bytes sent
+    QTest::setBenchmarkResult(qreal(bytes) / dragCount, QTest::BytesAllocated);
+}
+
+// More targets than a frame can hold are published before the subscriber connects, so
+// the snapshot it gets first has to be split into several frames
+void tst_Mirror::largeSnapshot()
+{
+    const int count = 70000;
+
+    QGraphicsScene scene;
+    QList<QGraphicsItem *> items;
+    for (int i = 0; i < count; ++i)
+    {
+        auto item = scene.addRect(0, 0, 10, 10);
+        item->setPos(i % 300 * 20, i / 300 * 20);
+        items.append(item);
+    }
+
+    auto name = QString("tst_mirror_snapshot_%1").arg(QCoreApplication::applicationPid());
+    ScalerMirrorPublisher publisher;
+    publisher.setFrameInterval(0);
+    QVERIFY(publisher.listen(name));
+
+    // A single scaler passed over every item publishes all of them
+    auto scaler = new GraphicsItemScaler(nullptr);
+    scene.addItem(scaler);
+    publisher.addScaler(scaler);
+    for (int i = 0; i < count; ++i)
+    {
+        publisher.addTarget(items.at(i), quint32(i));
+        scaler->setTarget(items.at(i));
+    }
+
+    QTRY_COMPARE_WITH_TIMEOUT(publisher.updatesSent(), quint64(count), 10000);
+    QCOMPARE(publisher.bytesSent(), quint64(0));
+
+    QProcess subscriber;
+    startSubscriber(&subscriber, name, count);
+    QVERIFY(subscriber.waitForStarted());
+    QTRY_VERIFY_WITH_TIMEOUT(publisher.bytesSent() > 0, 10000);
+
+    publisher.close();
+    QTRY_COMPARE_WITH_TIMEOUT(subscriber.state(), QProcess::NotRunning, 30000);
+    QCOMPARE(subscriber.exitCode(), 0);
+
+    auto output = subscriber.readAllStandardOutput();
+    QTextStream in(&output);
+
+    quint64 updatesApplied = 0, bytesReceived = 0;
+    in >> updatesApplied >> bytesReceived;
+    QCOMPARE(updatesApplied, quint64(count));
+    QCOMPARE(bytesReceived, publisher.bytesSent());
+
+    for (auto item : items)
+        QVERIFY(readTransform(&in, item->sceneTransform()));
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+
+    if (argc == 4 && qstrcmp(argv[1], "--subscriber") == 0)
+        return runSubscriber(QString::fromLocal8Bit(argv[2]), QByteArray(argv[3]).toInt());
+
+    tst_Mirror test;
+    QTEST_SET_MAIN_SOURCE_PATH
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_mirror.moc"
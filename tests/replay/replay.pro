@@ -0,0 +1,10 @@
+QT += testlib
+
+CONFIG += testcase
+
+TARGET = tst_replay
+TEMPLATE = app
+
+include(../../scaler/scaler.pri)
+
+SOURCES += tst_replay.cpp
@@ -0,0 +1,196 @@
+#include <QtTest>
+#include <QBuffer>
+#include <QGraphicsRectItem>
+#include <QGraphicsScene>
+#include <QGraphicsSceneMouseEvent>
+#include "graphicsitemscaler.h"
+#include "handleeventrecorder.h"
+#include "handleeventreplayer.h"
+
+// Attachment flags of the handles, as taken by GraphicsItemScaler::handleItem()
+static const int topLeftHandle = 0x1 | 0x2;
+static const int rightHandle = 0x8;
+static const int rotationHandle = 0x10;
+
+// Header of the session files, as written by HandleEventRecorder
+static const quint32 fileMagic = 0x47495352;
+
+static void sendMouseEvent(QGraphicsItem *handle, QEvent::Type type, const QPointF &scenePos, const QPointF &lastScenePos)
+{
+    QGraphicsSceneMouseEvent event(type);
+    event.setPos(handle->mapFromScene(scenePos));
+    event.setScenePos(scenePos);
+    event.setLastScenePos(lastScenePos);
+    event.setButton(type == QEvent::GraphicsSceneMouseMove ? Qt::NoButton : Qt::LeftButton);
+    event.setButtons(type == QEvent::GraphicsSceneMouseRelease ? Qt::NoButton : Qt::LeftButton);
+    handle->scene()->sendEvent(handle, &event);
+}
+
+static void drag(GraphicsItemScaler *scaler, int attachment, const QPointF &distance)
+{
+    const int steps = 10;
+
+    auto handle = scaler->handleItem(attachment);
+    auto scenePos = handle->sceneBoundingRect().center();
+    sendMouseEvent(handle, QEvent::GraphicsSceneMousePress, scenePos, scenePos);
+
+    for (int i = 0; i < steps; ++i)
+    {
+        auto lastScenePos = scenePos;
+        scenePos += distance / steps;
+        sendMouseEvent(handle, QEvent::GraphicsSceneMouseMove, scenePos, lastScenePos);
+    }
+
+    sendMouseEvent(handle, QEvent::GraphicsSceneMouseRelease, scenePos, scenePos);
+}
+
+static bool fuzzyEqual(const QTransform &a, const QTransform &b)
+{
+    return qAbs(a.m11() - b.m11()) < 1e-9 && qAbs(a.m12() - b.m12()) < 1e-9
+        && qAbs(a.m21() - b.m21()) < 1e-9 && qAbs(a.m22() - b.m22()) < 1e-9
+        && qAbs(a.dx() - b.dx()) < 1e-6 && qAbs(a.dy() - b.dy()) < 1e-6;
+}
+
+static GraphicsItemScaler *addScaler(QGraphicsScene *scene, const QRectF &targetRect, const QPointF &pos)
+{
+    auto scaler = new GraphicsItemScaler(new QGraphicsRectItem(targetRect));
+    scaler->setPos(pos);
+    scene->addItem(scaler);
+    return scaler;
+}
+
+// Writes the events in the format of the first version, which had no initial state
+static QByteArray versionOneFile(const QVector<HandleEvent> &events)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << fileMagic << quint16(1) << quint32(events.size());
+
+    qint64 previous = 0;
+    for (const auto &e : events)
+    {
+        stream << quint8(e.type) << quint8(e.attachment) << e.modifiers
+               << quint32(e.timestamp - previous)
+               << e.pos.x() << e.pos.y()
+               << e.scenePos.x() << e.scenePos.y()
+               << e.lastScenePos.x() << e.lastScenePos.y();
+        previous = e.timestamp;
+    }
+    return data;
+}
+
+// Records drags of every kind of handle, saves and loads the session and replays it
+// on another scaler, which has to end with the recorded geometry
+class tst_Replay : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void replayRestoresInitialState();
+    void versionOne();
+    void oversizedCount();
+
+private:
+    HandleSession mRecorded;
+    QTransform mFinalTransform;
+    QByteArray mFile;
+};
+
+void tst_Replay::initTestCase()
+{
+    QGraphicsScene scene;
+    auto scaler = addScaler(&scene, QRectF(0, 0, 100, 80), QPointF(50, 60));
+
+    HandleEventRecorder recorder;
+    scaler->setHandleEventRecorder(&recorder);
+
+    drag(scaler, rightHandle, QPointF(30, 0));
+    drag(scaler, topLeftHandle, QPointF(-20, -10));
+    drag(scaler, rotationHandle, QPointF(40, 20));
+    drag(scaler, rightHandle, QPointF(15, 5));
+
+    mRecorded = recorder.session();
+    mFinalTransform = scaler->target()->sceneTransform();
+
+    QVERIFY(mRecorded.hasInitialState);
+    QCOMPARE(mRecorded.targetRect, QRectF(0, 0, 100, 80));
+    QVERIFY(!qFuzzyIsNull(scaler->rotation()));
+
+    QBuffer buffer(&mFile);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY(recorder.save(&buffer));
+}
+
+void tst_Replay::replayRestoresInitialState()
+{
+    QBuffer buffer(&mFile);
+    buffer.open(QIODevice::ReadOnly);
+
+    HandleSession session;
+    QVERIFY(HandleEventRecorder::load(&buffer, &session));
+    QVERIFY(session.hasInitialState);
+    QVERIFY(session.initialState == mRecorded.initialState);
+    QCOMPARE(session.targetRect, mRecorded.targetRect);
+    QCOMPARE(session.events.size(), mRecorded.events.size());
+
+    // A stand-in target placed elsewhere, the initial state puts it where the session started
+    QGraphicsScene scene;
+    auto scaler = addScaler(&scene, session.targetRect, QPointF(300, 200));
+    scaler->setRotationAroundCenter(45);
+
+    HandleEventReplayer replayer(scaler);
+    replayer.setSession(session);
+    replayer.start();
+
+    QVERIFY(!replayer.isRunning());
+    QCOMPARE(replayer.eventDurations().size(), session.events.size());
+    QVERIFY2(fuzzyEqual(scaler->target()->sceneTransform(), mFinalTransform),
+             "The replayed geometry differs from the recorded one");
+}
+
+void tst_Replay::versionOne()
+{
+    auto data = versionOneFile(mRecorded.events);
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+
+    HandleSession session;
+    QVERIFY(HandleEventRecorder::load(&buffer, &session));
+    QVERIFY(!session.hasInitialState);
+    QCOMPARE(session.events.size(), mRecorded.events.size());
+
+    // Without an initial state the scaler has to be prepared as it was when recording
+    QGraphicsScene scene;
+    auto scaler = addScaler(&scene, QRectF(0, 0, 100, 80), QPointF(50, 60));
+
+    HandleEventReplayer replayer(scaler);
+    replayer.setSession(session);
+    replayer.start();
+
+    QVERIFY(fuzzyEqual(scaler->target()->sceneTransform(), mFinalTransform));
+}
+
+void tst_Replay::oversizedCount()
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    // No initial state, an empty target rect and a count no file of this size can hold
+    stream << fileMagic << quint16(2) << quint8(0) << QRectF() << quint32(0xffffffff);
+
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+
+    HandleSession session;
+    QVERIFY(!HandleEventRecorder::load(&buffer, &session));
+    QVERIFY(session.events.isEmpty());
+    QVERIFY(session.events.capacity() < 1024);
+}
+
+QTEST_MAIN(tst_Replay)
+
+#include "tst_replay.moc"
@@ -0,0 +1,10 @@
+QT += testlib
+
+CONFIG += testcase
+
+TARGET = tst_selection
+TEMPLATE = app
+
+include(../../scaler/scaler.pri)
+
+SOURCES += tst_selection.cpp
@@ -0,0 +1,382 @@
+#include <QtTest>
+#include <QGraphicsRectItem>
+#include <QGraphicsScene>
+#include <QGraphicsSceneMouseEvent>
+#include <QUndoStack>
+#include "graphicsitemscaler.h"
+#include "scalercommands.h"
+#include "scalerselectionmanager.h"
+
+// Attachment flag of the right handle, as taken by GraphicsItemScaler::handleItem()
+static const int rightHandle = 0x8;
+
+static QList<QGraphicsItem *> addItems(QGraphicsScene *scene, int count)
+{
+    QList<QGraphicsItem *> items;
+    for (int i = 0; i < count; ++i)
+    {
+        auto item = scene->addRect(0, 0, 10, 10);
+        item->setPos(i % 100 * 20, i / 100 * 20);
+        item->setFlag(QGraphicsItem::ItemIsSelectable);
+        items.append(item);
+    }
+    return items;
+}
+
+static void sendMouseEvent(QGraphicsItem *handle, QEvent::Type type, const QPointF &scenePos, const QPointF &lastScenePos)
+{
+    QGraphicsSceneMouseEvent event(type);
+    event.setPos(handle->mapFromScene(scenePos));
+    event.setScenePos(scenePos);
+    event.setLastScenePos(lastScenePos);
+    event.setButton(type == QEvent::GraphicsSceneMouseMove ? Qt::NoButton : Qt::LeftButton);
+    event.setButtons(type == QEvent::GraphicsSceneMouseRelease ? Qt::NoButton : Qt::LeftButton);
+    handle->scene()->sendEvent(handle, &event);
+}
+
+// Drags the right handle of the scaler by the given distance
+static void dragRightHandle(GraphicsItemScaler *scaler, qreal distance)
+{
+    auto handle = scaler->handleItem(rightHandle);
+    auto pos = handle->sceneBoundingRect().center();
+    auto end = pos + QPointF(distance, 0);
+
+    sendMouseEvent(handle, QEvent::GraphicsSceneMousePress, pos, pos);
+    sendMouseEvent(handle, QEvent::GraphicsSceneMouseMove, end, pos);
+    sendMouseEvent(handle, QEvent::GraphicsSceneMouseRelease, end, end);
+}
+
+class tst_Selection : public QObject
+{
+    Q_OBJECT
+private slots:
+    void deleteSelectedTarget();
+    void deleteSceneFirst();
+    void undoAfterRetarget();
+    void undoAfterSceneCleared();
+    void retargetDuringDrag();
+    void rotatedTarget();
+    void bulkScaleBeyondScalerLimit();
+
+    void selectionLatency_data();
+    void selectionLatency();
+    void largeSelection_data();
+    void largeSelection();
+};
+
+void tst_Selection::deleteSelectedTarget()
+{
+    QGraphicsScene scene;
+    auto items = addItems(&scene, 2);
+    ScalerSelectionManager manager(&scene);
+
+    items.at(0)->setSelected(true);
+    QCOMPARE(manager.scalers().size(), 1);
+    auto scaler = manager.scalers().first();
+    QCOMPARE(scaler->target(), items.at(0));
+
+    delete items.at(0);
+    QVERIFY(manager.scalers().isEmpty());
+    QVERIFY(!scaler->target());
+
+    // The pooled scaler is reused for the next selection
+    items.at(1)->setSelected(true);
+    QCOMPARE(manager.scalers().size(), 1);
+    QCOMPARE(manager.scalers().first(), scaler);
+    QCOMPARE(scaler->target(), items.at(1));
+}
+
+void tst_Selection::deleteSceneFirst()
+{
+    auto scene = new QGraphicsScene;
+    auto items = addItems(scene, 3);
+    ScalerSelectionManager manager(scene);
+
+    items.at(0)->setSelected(true);
+    items.at(1)->setSelected(true);
+    QCOMPARE(manager.scalers().size(), 2);
+
+    // A pooled scaler goes with the scene as well
+    items.at(1)->setSelected(false);
+
+    delete scene;
+    QVERIFY(manager.scalers().isEmpty());
+    manager.updateScalers();
+}
+
+void tst_Selection::undoAfterRetarget()
+{
+    QGraphicsScene scene;
+    auto items = addItems(&scene, 2);
+    QUndoStack stack;
+
+    ScalerSelectionManager manager(&scene);
+    connect(&manager, &ScalerSelectionManager::scalerCreated, [&stack](GraphicsItemScaler *scaler) {
+        scaler->setUndoStack(&stack);
+    });
+
+    items.at(0)->setSelected(true);
+    auto scaler = manager.scalers().first();
+    auto firstRect = items.at(0)->sceneBoundingRect();
+    auto secondRect = items.at(1)->sceneBoundingRect();
+
+    dragRightHandle(scaler, 40);
+    QCOMPARE(stack.count(), 1);
+
+    auto scaledRect = items.at(0)->sceneBoundingRect();
+    QVERIFY(scaledRect != firstRect);
+
+    scene.clearSelection();
+    items.at(1)->setSelected(true);
+    QCOMPARE(scaler->target(), items.at(1));
+
+    // The command belongs to the first item, not to the scaler now holding the second one
+    stack.undo();
+    QCOMPARE(items.at(0)->sceneBoundingRect(), firstRect);
+    QCOMPARE(items.at(1)->sceneBoundingRect(), secondRect);
+
+    stack.redo();
+    QCOMPARE(items.at(0)->sceneBoundingRect(), scaledRect);
+    QCOMPARE(items.at(1)->sceneBoundingRect(), secondRect);
+}
+
+void tst_Selection::undoAfterSceneCleared()
+{
+    QGraphicsScene scene;
+    auto items = addItems(&scene, 2);
+    QUndoStack stack;
+
+    ScalerSelectionManager manager(&scene);
+    connect(&manager, &ScalerSelectionManager::scalerCreated, [&stack](GraphicsItemScaler *scaler) {
+        scaler->setUndoStack(&stack);
+    });
+
+    items.at(0)->setSelected(true);
+    items.at(1)->setSelected(true);
+    dragRightHandle(GraphicsItemScaler::scalerOf(items.at(0)), 40);
+    dragRightHandle(GraphicsItemScaler::scalerOf(items.at(1)), 40);
+    QCOMPARE(stack.count(), 2);
+
+    // The targets go with their scalers, the commands must not refer to them anymore
+    scene.clear();
+    QVERIFY(manager.scalers().isEmpty());
+
+    stack.undo();
+    stack.undo();
+    stack.redo();
+    stack.redo();
+
+    // A new item may be given the address of a deleted one
+    auto item = scene.addRect(0, 0, 10, 10);
+    auto transform = item->transform();
+    stack.undo();
+    QCOMPARE(item->transform(), transform);
+}
+
+void tst_Selection::retargetDuringDrag()
+{
+    QGraphicsScene scene;
+    auto items = addItems(&scene, 2);
+    QUndoStack stack;
+
+    ScalerSelectionManager manager(&scene);
+    connect(&manager, &ScalerSelectionManager::scalerCreated, [&stack](GraphicsItemScaler *scaler) {
+        scaler->setUndoStack(&stack);
+    });
+
+    items.at(0)->setSelected(true);
+    auto scaler = manager.scalers().first();
+    auto firstRect = items.at(0)->sceneBoundingRect();
+    auto secondRect = items.at(1)->sceneBoundingRect();
+
+    auto handle = scaler->handleItem(rightHandle);
+    auto pos = handle->sceneBoundingRect().center();
+    sendMouseEvent(handle, QEvent::GraphicsSceneMousePress, pos, pos);
+    sendMouseEvent(handle, QEvent::GraphicsSceneMouseMove, pos + QPointF(40, 0), pos);
+    auto scaledRect = items.at(0)->sceneBoundingRect();
+
+    // Someone else changes the selection in the middle of the drag
+    scene.clearSelection();
+    items.at(1)->setSelected(true);
+    QCOMPARE(scaler->target(), items.at(1));
+    QCOMPARE(stack.count(), 1);
+
+    // The rest of the drag reaches the new target neither
+    sendMouseEvent(handle, QEvent::GraphicsSceneMouseMove, pos + QPointF(80, 0), pos + QPointF(40, 0));
+    sendMouseEvent(handle, QEvent::GraphicsSceneMouseRelease, pos + QPointF(80, 0), pos + QPointF(80, 0));
+    QCOMPARE(items.at(0)->sceneBoundingRect(), scaledRect);
+    QCOMPARE(items.at(1)->sceneBoundingRect(), secondRect);
+    QCOMPARE(stack.count(), 1);
+
+    stack.undo();
+    QCOMPARE(items.at(0)->sceneBoundingRect(), firstRect);
+    QCOMPARE(items.at(1)->sceneBoundingRect(), secondRect);
+}
+
+// Cosine of the angle between the mapped axes of the item, 0 unless it is sheared
+static qreal shear(const QGraphicsItem *item)
+{
+    auto t = item->sceneTransform();
+    QLineF x(t.map(QPointF()), t.map(QPointF(1, 0)));
+    QLineF y(t.map(QPointF()), t.map(QPointF(0, 1)));
+    return (x.dx() * y.dx() + x.dy() * y.dy()) / (x.length() * y.length());
+}
+
+void tst_Selection::rotatedTarget()
+{
+    QGraphicsScene scene;
+    auto items = addItems(&scene, 2);
+    auto item = items.at(0);
+    item->setPos(100, 100);
+    item->setTransform(QTransform().rotate(30));
+    auto center = item->sceneBoundingRect().center();
+
+    ScalerSelectionManager manager(&scene);
+
+    // The rotation is the same after the target was released and attached again
+    for (int i = 0; i < 2; ++i)
+    {
+        item->setSelected(true);
+        auto scaler = GraphicsItemScaler::scalerOf(item);
+        QVERIFY(scaler);
+        QCOMPARE(scaler->rotation(), 30.0);
+        QVERIFY(qFuzzyIsNull(item->itemTransform(scaler).m12()));
+
+        auto sceneCenter = item->sceneBoundingRect().center();
+        QCOMPARE(sceneCenter, center);
+
+        item->setSelected(false);
+        QCOMPARE(item->sceneBoundingRect().center(), center);
+    }
+
+    // Scaling along the axes of the target does not shear it
+    item->setSelected(true);
+    dragRightHandle(GraphicsItemScaler::scalerOf(item), 20);
+    QVERIFY(qAbs(shear(item)) < 1e-9);
+
+    item->setSelected(false);
+    QVERIFY(qAbs(shear(item)) < 1e-9);
+}
+
+void tst_Selection::bulkScaleBeyondScalerLimit()
+{
+    QGraphicsScene scene;
+    auto items = addItems(&scene, 1000);
+    QUndoStack stack;
+
+    // Only some of the items get a scaler
+    ScalerSelectionManager manager(&scene);
+    for (auto item : items)
+        item->setSelected(true);
+    QCOMPARE(manager.scalers().size(), manager.maximumScalers());
+
+    QVector<QRectF> before;
+    for (auto item : items)
+        before.append(item->sceneBoundingRect());
+
+    auto command = new BulkScaleCommand(items, "Scale all");
+    QCOMPARE(command->count(), items.size());
+
+    for (auto item : items)
+    {
+        item->setTransform(QTransform::fromScale(2, 1), true);
+        if (auto scaler = GraphicsItemScaler::scalerOf(item))
+            scaler->recalculate();
+    }
+
+    QVector<QRectF> after;
+    for (auto item : items)
+        after.append(item->sceneBoundingRect());
+
+    stack.push(command);
+
+    stack.undo();
+    for (int i = 0; i < items.size(); ++i)
+        QCOMPARE(items.at(i)->sceneBoundingRect(), before.at(i));
+
+    stack.redo();
+    for (int i = 0; i < items.size(); ++i)
+        QCOMPARE(items.at(i)->sceneBoundingRect(), after.at(i));
+}
+
+void tst_Selection::selectionLatency_data()
+{
+    QTest::addColumn<int>("itemCount");
+
+    QTest::newRow("1k items") << 1000;
+    QTest::newRow("10k items") << 10000;
+}
+
+// One iteration moves the selection to another ten items
+void tst_Selection::selectionLatency()
+{
+    QFETCH(int, itemCount);
+
+    QGraphicsScene scene;
+    auto items = addItems(&scene, itemCount);
+    ScalerSelectionManager manager(&scene);
+
+    int first = 0;
+    QBENCHMARK
+    {
+        scene.clearSelection();
+        for (int i = 0; i < 10; ++i)
+            items.at((first + i * 97) % itemCount)->setSelected(true);
+        first = (first + 1) % itemCount;
+    }
+
+    QVERIFY(manager.scalers().size() <= 10);
+}
+
+void tst_Selection::largeSelection_data()
+{
+    QTest::addColumn<int>("itemCount");
+    QTest::addColumn<bool>("select");
+
+    QTest::newRow("1k selected at once") << 1000 << true;
+    QTest::newRow("1k selected, update") << 1000 << false;
+    QTest::newRow("10k selected at once") << 10000 << true;
+    QTest::newRow("10k selected, update") << 10000 << false;
+}
+
+// Every item of the scene is selected, far more than the scalers allowed. Either the whole
+// selection is made again, with a single selectionChanged(), or only updateScalers() is run
+void tst_Selection::largeSelection()
+{
+    QFETCH(int, itemCount);
+    QFETCH(bool, select);
+
+    QGraphicsScene scene;
+    auto items = addItems(&scene, itemCount);
+    ScalerSelectionManager manager(&scene);
+
+    QPainterPath area;
+    area.addRect(scene.itemsBoundingRect().adjusted(-10, -10, 10, 10));
+    scene.setSelectionArea(area);
+    QVERIFY(scene.selectedItems().size() >= itemCount);
+    QCOMPARE(manager.scalers().size(), manager.maximumScalers());
+
+    if (select)
+    {
+        QBENCHMARK
+        {
+            scene.clearSelection();
+            scene.setSelectionArea(area);
+        }
+    }
+    else
+    {
+        QBENCHMARK
+        {
+            manager.updateScalers();
+        }
+    }
+
+    QCOMPARE(manager.scalers().size(), manager.maximumScalers());
+    for (auto scaler : manager.scalers())
+        QVERIFY(items.contains(scaler->target()));
+}
+
+QTEST_MAIN(tst_Selection)
+
+#include "tst_selection.moc"
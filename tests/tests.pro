@@ -0,0 +1,10 @@
+# Run with "make check". Tests showing widgets need a platform, e.g. QT_QPA_PLATFORM=offscreen
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    frameupdates \
+    mirror \
+    replay \
+    selection \
+    touch
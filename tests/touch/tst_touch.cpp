@@ -0,0 +1,230 @@
+#include <QtTest>
+#include <QGraphicsRectItem>
+#include <QGraphicsScene>
+#include <QTouchEvent>
+#include <QUndoStack>
+#include "graphicsitemscaler.h"
+
+// Attachment flags of the handles, as taken by GraphicsItemScaler::handleItem()
+static const int bottomHandle = 0x4;
+static const int rightHandle = 0x8;
+
+// Touch events are sent to the handles directly, so no view is needed
+class tst_Touch : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanup();
+
+    void twoScalersOneBatchPerFrame();
+    void cancelRestoresGeometry();
+    void releaseAtNewPosition();
+    void tenSimultaneousDrags();
+
+private:
+    GraphicsItemScaler *addScaler(QGraphicsScene *scene, const QPointF &pos);
+    bool sendTouch(QGraphicsItem *handle, QEvent::Type type, int id, Qt::TouchPointState state,
+                   const QPointF &scenePos, const QPointF &lastScenePos);
+
+    QTouchDevice *mDevice = nullptr;
+};
+
+void tst_Touch::initTestCase()
+{
+    mDevice = QTest::createTouchDevice();
+}
+
+void tst_Touch::cleanup()
+{
+    GraphicsItemScaler::setTouchBatchInterval(16);
+}
+
+GraphicsItemScaler *tst_Touch::addScaler(QGraphicsScene *scene, const QPointF &pos)
+{
+    auto target = new QGraphicsRectItem(0, 0, 100, 100);
+    target->setPen(Qt::NoPen);
+
+    auto scaler = new GraphicsItemScaler(target);
+    // Every applied move is reported
+    scaler->setScalingChangedFrequency(0);
+    scaler->setPos(pos);
+    scene->addItem(scaler);
+    return scaler;
+}
+
+bool tst_Touch::sendTouch(QGraphicsItem *handle, QEvent::Type type, int id, Qt::TouchPointState state,
+                          const QPointF &scenePos, const QPointF &lastScenePos)
+{
+    QTouchEvent::TouchPoint point(id);
+    point.setState(state);
+    point.setPos(handle->mapFromScene(scenePos));
+    point.setScenePos(scenePos);
+    point.setLastScenePos(lastScenePos);
+
+    QTouchEvent event(type, mDevice, Qt::NoModifier, state, QList<QTouchEvent::TouchPoint>() << point);
+    handle->scene()->sendEvent(handle, &event);
+    return event.isAccepted();
+}
+
+void tst_Touch::twoScalersOneBatchPerFrame()
+{
+    QGraphicsScene scene;
+    auto first = addScaler(&scene, QPointF(0, 0));
+    auto second = addScaler(&scene, QPointF(200, 0));
+
+    QSignalSpy firstSpy(first, &GraphicsItemScaler::scalingChanged);
+    QSignalSpy secondSpy(second, &GraphicsItemScaler::scalingChanged);
+
+    auto firstHandle = first->handleItem(rightHandle);
+    auto secondHandle = second->handleItem(bottomHandle);
+    QVERIFY(firstHandle && secondHandle);
+
+    auto firstRect = first->target()->sceneBoundingRect();
+    auto secondRect = second->target()->sceneBoundingRect();
+    auto firstPos = firstHandle->sceneBoundingRect().center();
+    auto secondPos = secondHandle->sceneBoundingRect().center();
+
+    QVERIFY(sendTouch(firstHandle, QEvent::TouchBegin, 1, Qt::TouchPointPressed, firstPos, firstPos));
+    QVERIFY(sendTouch(secondHandle, QEvent::TouchBegin, 2, Qt::TouchPointPressed, secondPos, secondPos));
+
+    // Several moves of both points within one frame
+    const QPointF step(10, 10);
+    for (int i = 0; i < 5; ++i)
+    {
+        sendTouch(firstHandle, QEvent::TouchUpdate, 1, Qt::TouchPointMoved, firstPos + step, firstPos);
+        sendTouch(secondHandle, QEvent::TouchUpdate, 2, Qt::TouchPointMoved, secondPos + step, secondPos);
+        firstPos += step;
+        secondPos += step;
+    }
+
+    QCOMPARE(firstSpy.count(), 0);
+    QCOMPARE(secondSpy.count(), 0);
+    QCOMPARE(first->target()->sceneBoundingRect(), firstRect);
+
+    QTRY_COMPARE(firstSpy.count(), 1);
+    QTRY_COMPARE(secondSpy.count(), 1);
+
+    // No further batch without new moves
+    QTest::qWait(50);
+    QCOMPARE(firstSpy.count(), 1);
+    QCOMPARE(secondSpy.count(), 1);
+
+    // Each handle scales along its own axis only, by the whole accumulated move
+    auto firstAfter = first->target()->sceneBoundingRect();
+    QCOMPARE(firstAfter.topLeft(), firstRect.topLeft());
+    QCOMPARE(firstAfter.width(), firstRect.width() + 50);
+    QCOMPARE(firstAfter.height(), firstRect.height());
+
+    auto secondAfter = second->target()->sceneBoundingRect();
+    QCOMPARE(secondAfter.topLeft(), secondRect.topLeft());
+    QCOMPARE(secondAfter.width(), secondRect.width());
+    QCOMPARE(secondAfter.height(), secondRect.height() + 50);
+
+    QVERIFY(sendTouch(firstHandle, QEvent::TouchEnd, 1, Qt::TouchPointReleased, firstPos, firstPos));
+    QVERIFY(sendTouch(secondHandle, QEvent::TouchEnd, 2, Qt::TouchPointReleased, secondPos, secondPos));
+
+    QCOMPARE(first->target()->sceneBoundingRect(), firstAfter);
+    QCOMPARE(second->target()->sceneBoundingRect(), secondAfter);
+}
+
+void tst_Touch::cancelRestoresGeometry()
+{
+    QGraphicsScene scene;
+    QUndoStack stack;
+
+    auto scaler = addScaler(&scene, QPointF(10, 10));
+    scaler->setUndoStack(&stack);
+    QSignalSpy finishedSpy(scaler, &GraphicsItemScaler::scalingFinished);
+
+    auto handle = scaler->handleItem(rightHandle);
+    auto rect = scaler->target()->sceneBoundingRect();
+    auto scalerPos = scaler->pos();
+    auto pos = handle->sceneBoundingRect().center();
+
+    QVERIFY(sendTouch(handle, QEvent::TouchBegin, 1, Qt::TouchPointPressed, pos, pos));
+    sendTouch(handle, QEvent::TouchUpdate, 1, Qt::TouchPointMoved, pos + QPointF(30, 0), pos);
+    QTRY_VERIFY(scaler->target()->sceneBoundingRect() != rect);
+
+    // A move still waiting for its frame is dropped as well
+    sendTouch(handle, QEvent::TouchUpdate, 1, Qt::TouchPointMoved, pos + QPointF(60, 0), pos + QPointF(30, 0));
+    sendTouch(handle, QEvent::TouchCancel, 1, Qt::TouchPointReleased, pos + QPointF(60, 0), pos + QPointF(60, 0));
+
+    QCOMPARE(scaler->target()->sceneBoundingRect(), rect);
+    QCOMPARE(scaler->pos(), scalerPos);
+    QCOMPARE(finishedSpy.count(), 1);
+    QCOMPARE(stack.count(), 0);
+
+    QTest::qWait(50);
+    QCOMPARE(scaler->target()->sceneBoundingRect(), rect);
+}
+
+void tst_Touch::releaseAtNewPosition()
+{
+    QGraphicsScene scene;
+    auto scaler = addScaler(&scene, QPointF(10, 10));
+
+    auto handle = scaler->handleItem(rightHandle);
+    auto rect = scaler->target()->sceneBoundingRect();
+    auto pos = handle->sceneBoundingRect().center();
+
+    QVERIFY(sendTouch(handle, QEvent::TouchBegin, 1, Qt::TouchPointPressed, pos, pos));
+    sendTouch(handle, QEvent::TouchUpdate, 1, Qt::TouchPointMoved, pos + QPointF(10, 0), pos);
+    QTRY_COMPARE(scaler->target()->sceneBoundingRect().width(), rect.width() + 10);
+
+    // The finger is lifted further than the last move, the target follows it
+    QVERIFY(sendTouch(handle, QEvent::TouchEnd, 1, Qt::TouchPointReleased, pos + QPointF(30, 0), pos + QPointF(10, 0)));
+    QCOMPARE(scaler->target()->sceneBoundingRect().width(), rect.width() + 30);
+
+    // The same for a release within an update, with a move still waiting for its frame
+    rect = scaler->target()->sceneBoundingRect();
+    pos = handle->sceneBoundingRect().center();
+
+    QVERIFY(sendTouch(handle, QEvent::TouchBegin, 2, Qt::TouchPointPressed, pos, pos));
+    sendTouch(handle, QEvent::TouchUpdate, 2, Qt::TouchPointMoved, pos + QPointF(10, 0), pos);
+    sendTouch(handle, QEvent::TouchUpdate, 2, Qt::TouchPointReleased, pos + QPointF(20, 0), pos + QPointF(10, 0));
+    QCOMPARE(scaler->target()->sceneBoundingRect().width(), rect.width() + 20);
+
+    QTest::qWait(50);
+    QCOMPARE(scaler->target()->sceneBoundingRect().width(), rect.width() + 20);
+}
+
+void tst_Touch::tenSimultaneousDrags()
+{
+    // Every processEvents() call below is one frame
+    GraphicsItemScaler::setTouchBatchInterval(0);
+
+    QGraphicsScene scene;
+    QList<QGraphicsItem *> handles;
+    for (int i = 0; i < 10; ++i)
+        handles.append(addScaler(&scene, QPointF(i * 150, 0))->handleItem(rightHandle));
+
+    QBENCHMARK
+    {
+        QVector<QPointF> positions;
+        for (int i = 0; i < handles.size(); ++i)
+        {
+            positions.append(handles.at(i)->sceneBoundingRect().center());
+            sendTouch(handles.at(i), QEvent::TouchBegin, i, Qt::TouchPointPressed, positions.at(i), positions.at(i));
+        }
+
+        // Back and forth, so the targets keep their size over the iterations
+        for (int frame = 0; frame < 10; ++frame)
+        {
+            const QPointF step(frame % 2 ? -2 : 2, 0);
+            for (int i = 0; i < handles.size(); ++i)
+            {
+                sendTouch(handles.at(i), QEvent::TouchUpdate, i, Qt::TouchPointMoved, positions.at(i) + step, positions.at(i));
+                positions[i] += step;
+            }
+            QCoreApplication::processEvents();
+        }
+
+        for (int i = 0; i < handles.size(); ++i)
+            sendTouch(handles.at(i), QEvent::TouchEnd, i, Qt::TouchPointReleased, positions.at(i), positions.at(i));
+    }
+}
+
+QTEST_MAIN(tst_Touch)
+
+#include "tst_touch.moc"